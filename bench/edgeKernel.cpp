@@ -0,0 +1,160 @@
+// Microbenchmark of one explicit step's edge work: the original separate passes
+// (`computeFlows` + `updateConductances` + `conductanceConverged`) against the fused kernel,
+// and the kernels specialized for the law's exponents against their `std::pow` fallback.
+// Build and run with `make bench`.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <Dense>
+
+#include "EdgeKernel/EdgeKernel.hpp"
+
+namespace
+{
+    struct State
+    {
+        Eigen::VectorXd D, Q, dD;
+    };
+
+    // the passes as `Graph` made them before the fused kernel
+    struct Legacy
+    {
+        const std::vector<unsigned int>& ei;
+        const std::vector<unsigned int>& ej;
+        const EdgeKernel::Coefficients& law;
+        double tol;
+        bool fitnessConverged { false };
+
+        double dissipation(const Eigen::VectorXd& Q, const Eigen::VectorXd& D) const
+        {
+            return (Q.cwiseProduct(Q).cwiseQuotient(D) + law.c_t * D.array().pow(0.5).matrix()).sum();
+        }
+
+        void computeFlows(const Eigen::VectorXd& p, State& x)
+        {
+            double E_old { dissipation(x.Q, x.D - x.dD) };
+            for (unsigned int k = 0; k < x.D.size(); ++k)
+            {
+                x.Q(k) = x.D(k) * (p(ei[k]) - p(ej[k]));
+            }
+            if ((dissipation(x.Q, x.D) - E_old) / E_old < tol) { fitnessConverged = true; }
+        }
+
+        void updateConductances(State& x, double dt) const
+        {
+            for (unsigned int k = 0; k < x.D.size(); ++k)
+            {
+                double Qgamma { pow(std::abs(x.Q(k)), law.gamma) };
+                x.dD(k) = dt * (law.alpha * Qgamma / (1.0 + Qgamma) - law.beta * x.D(k));
+                x.D(k) += x.dD(k);
+                if (x.D(k) < law.D_min)
+                {
+                    x.dD(k) -= law.D_min - x.D(k);
+                    x.D(k) = law.D_min;
+                }
+            }
+        }
+
+        bool conductanceConverged(const State& x) const
+        {
+            return x.dD.norm() / x.D.norm() < tol;
+        }
+    };
+
+    template <typename Step>
+    double secondsPerStep(Step&& step, int reps)
+    {
+        step(); // warm up
+        auto start { std::chrono::steady_clock::now() };
+        for (int r = 0; r < reps; ++r) { step(); }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / reps;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // square lattice with `side` nodes per side, as built by `Graph::regularLattice`
+    const unsigned int side { argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 201 };
+    const int reps { argc > 2 ? std::atoi(argv[2]) : 200 };
+
+    std::vector<unsigned int> ei, ej;
+    for (unsigned int r = 0; r < side; ++r)
+    {
+        for (unsigned int c = 0; c < side; ++c)
+        {
+            unsigned int n { r * side + c };
+            if (c + 1 < side) { ei.push_back(n); ej.push_back(n + 1); }
+            if (r + 1 < side) { ei.push_back(n); ej.push_back(n + side); }
+        }
+    }
+    const int nEdges { static_cast<int>(ei.size()) };
+    const int nNodes { static_cast<int>(side * side) };
+
+    // a mid-evolution state: spread of live conductances, a share of edges at the floor
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const EdgeKernel::Coefficients law { 100.0, 10.0, 3.0, 2.0, 0.5, 1e-14 };
+    const double dt { 0.025 };
+
+    Eigen::VectorXd p(nNodes);
+    for (int i = 0; i < nNodes; ++i) { p(i) = uniform(rng); }
+
+    State init { Eigen::VectorXd(nEdges), Eigen::VectorXd(nEdges), Eigen::VectorXd(nEdges) };
+    for (int k = 0; k < nEdges; ++k)
+    {
+        init.D(k) = uniform(rng) < 0.7 ? law.D_min : std::pow(10.0, -4.0 + 5.0 * uniform(rng));
+        init.Q(k) = init.D(k) * (uniform(rng) - 0.5);
+        init.dD(k) = 0.0;
+    }
+
+    EdgeKernel::Endpoints endpoints;
+    endpoints.i.assign(ei.begin(), ei.end());
+    endpoints.j.assign(ej.begin(), ej.end());
+
+    // the state keeps evolving across repetitions with frozen pressures, identically for both variants
+    State legacyState { init };
+    Legacy legacy { ei, ej, law, 1e-8 };
+    bool legacyConverged { false };
+    double tLegacy { secondsPerStep([&]
+    {
+        legacy.computeFlows(p, legacyState);
+        legacy.updateConductances(legacyState, dt);
+        legacyConverged = legacy.conductanceConverged(legacyState);
+    }, reps) };
+
+    const EdgeKernel::Policy& specialized { EdgeKernel::policy(EdgeKernel::GrowthLaw::Sigmoid, law.gamma, law.kappa) };
+    const EdgeKernel::Policy& generic { EdgeKernel::policy(EdgeKernel::GrowthLaw::Sigmoid, law.gamma, law.kappa, false) };
+
+    State fusedState { init };
+    EdgeKernel::Sums sums {};
+    double tFused { secondsPerStep([&]
+    {
+        sums = specialized.eulerStep(endpoints, p.data(), fusedState.D.data(), fusedState.Q.data(), fusedState.dD.data(), law, dt);
+    }, reps) };
+
+    State genericState { init };
+    double tGeneric { secondsPerStep([&]
+    {
+        generic.eulerStep(endpoints, p.data(), genericState.D.data(), genericState.Q.data(), genericState.dD.data(), law, dt);
+    }, reps) };
+
+    double diff { std::max((fusedState.D - legacyState.D).cwiseAbs().maxCoeff(), (genericState.D - legacyState.D).cwiseAbs().maxCoeff())
+                  / legacyState.D.cwiseAbs().maxCoeff() };
+
+    std::cout << "edges : " << nEdges << ", repetitions : " << reps << '\n';
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "legacy passes : " << 1e9 * tLegacy / nEdges << " ns/edge" << '\n';
+    std::cout << "fused, pow    : " << 1e9 * tGeneric / nEdges << " ns/edge" << '\n';
+    std::cout << "fused kernel  : " << 1e9 * tFused / nEdges << " ns/edge (gamma = 3, kappa = 1/2 unrolled)" << '\n';
+    std::cout << "speedup       : " << tLegacy / tFused << "x" << '\n';
+    std::cout << std::scientific << std::setprecision(3);
+    std::cout << "max rel. difference of D : " << diff << '\n';
+    std::cout << "converged (legacy/fused) : " << legacyConverged << '/' << (std::sqrt(sums.dD2 / sums.D2) < 1e-8) << '\n';
+}
@@ -0,0 +1,67 @@
+// Ensemble of small lattices evolved to convergence: one `Graph` per seed against a `GraphBatch` of the same seeds.
+// Build and run with `make bench` (arguments: half resolution, seeds per batch).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Graph/Graph.hpp"
+#include "GraphBatch/GraphBatch.hpp"
+
+namespace
+{
+    double seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int res { argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 10 };
+    const std::size_t K { argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2])) : 32 };
+    const double dt { 0.025 };
+
+    std::vector<uint32_t> seeds(K);
+    for (std::size_t b = 0; b < K; ++b) { seeds[b] = static_cast<uint32_t>(1000 + b); }
+
+    // the graphs announce their seeds on construction
+    std::streambuf* log { std::cout.rdbuf(nullptr) };
+
+    auto start { std::chrono::steady_clock::now() };
+    std::vector<Eigen::VectorXd> single;
+    std::size_t singleSteps { 0 };
+    for (uint32_t seed : seeds)
+    {
+        Graph graph(seed, 2.0f, 2.0f, 2 * res + 1);
+        do { graph.evolveGraph(dt); } while (!(graph.conductanceConverged() && graph.fitConverged()));
+        singleSteps += graph.steps();
+        single.push_back(graph.getD());
+    }
+    double tSingle { seconds(start) };
+
+    start = std::chrono::steady_clock::now();
+    GraphBatch batch(seeds, 2.0f, 2.0f, 2 * res + 1);
+    while (batch.activeCount() > 0) { batch.evolve(dt); }
+    double tBatch { seconds(start) };
+
+    std::size_t batchSteps { 0 };
+    double diff { 0.0 };
+    for (std::size_t b = 0; b < K; ++b)
+    {
+        batchSteps += batch.graph(b).steps();
+        diff = std::max(diff, (batch.graph(b).getD() - single[b]).cwiseAbs().maxCoeff() / single[b].cwiseAbs().maxCoeff());
+    }
+
+    std::cout.rdbuf(log);
+    std::cout << std::setprecision(4);
+    std::cout << "lattice " << 2 * res + 1 << " x " << 2 * res + 1 << ", " << K << " seeds" << '\n';
+    std::cout << "one graph per seed : " << tSingle << " s (" << singleSteps << " steps)" << '\n';
+    std::cout << "lock-step batch    : " << tBatch << " s (" << batchSteps << " steps)" << '\n';
+    std::cout << "speedup            : " << tSingle / tBatch << "x" << '\n';
+    std::cout << "max rel. difference of D : " << diff << '\n';
+}
@@ -0,0 +1,72 @@
+// Per-step cost of the pressure solve on growing lattices: sparse Cholesky against multigrid-preconditioned CG.
+// Build and run with `make bench` (arguments: largest half resolution, largest half resolution still factorized).
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Graph/Graph.hpp"
+
+namespace
+{
+    double seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // seconds per Euler step after a few steps into the evolution (so the conductances have started to spread)
+    double perStep(unsigned int resolution, PressureSolver type, int steps, double& iterations)
+    {
+        const double dt { 0.025 };
+        Graph graph(1000, 2.0f, 2.0f, resolution);
+        graph.setPressureSolver(type);
+        for (int i = 0; i < 5; ++i) { graph.evolveGraph(dt); }
+
+        iterations = 0.0;
+        auto start { std::chrono::steady_clock::now() };
+        for (int i = 0; i < steps; ++i)
+        {
+            graph.evolveGraph(dt);
+            iterations += graph.pressureIterations();
+        }
+        iterations /= steps;
+        return seconds(start) / steps;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int maxRes { argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 500 };
+    const unsigned int maxDirect { argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 200 };
+
+    // the graphs announce their seeds on construction
+    std::streambuf* log { std::cout.rdbuf(nullptr) };
+    std::vector<unsigned int> resolutions {};
+    for (unsigned int res = 25; res <= maxRes; res *= 2) { resolutions.push_back(2 * res + 1); }
+
+    std::vector<double> direct {}, multigrid {}, iterations {};
+    for (unsigned int resolution : resolutions)
+    {
+        double its { 0.0 };
+        int steps { resolution > 500 ? 2 : 5 };
+        direct.push_back(resolution <= 2 * maxDirect + 1 ? perStep(resolution, PressureSolver::Cholesky, steps, its) : -1.0);
+        multigrid.push_back(perStep(resolution, PressureSolver::Multigrid, steps, its));
+        iterations.push_back(its);
+    }
+
+    std::cout.rdbuf(log);
+    std::cout << std::setprecision(4);
+    std::cout << "lattice    nodes      Cholesky [s/step]  multigrid [s/step]  CG iterations  multigrid [us/node/step]" << '\n';
+    for (std::size_t i = 0; i < resolutions.size(); ++i)
+    {
+        const double nodes { static_cast<double>(resolutions[i]) * resolutions[i] };
+        std::cout << std::setw(5) << resolutions[i] << std::setw(12) << static_cast<std::size_t>(nodes)
+                  << std::setw(19);
+        if (direct[i] < 0.0) { std::cout << "-"; }
+        else { std::cout << direct[i]; }
+        std::cout << std::setw(20) << multigrid[i] << std::setw(15) << iterations[i]
+                  << std::setw(26) << multigrid[i] / nodes * 1e6 << '\n';
+    }
+}
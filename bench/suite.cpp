@@ -0,0 +1,182 @@
+// Timings of the `Graph` hot paths over a resolution sweep, for regression comparisons between revisions:
+// construction (`regularLattice` + `initLaplacian`), `updateLaplacian`, the pressure solve split into
+// assembly, factorization and triangular solves, `computeFlows`, `updateConductances`, one Hessian probe,
+// `sampleHSpec` over thread counts and a full run to the steady state.
+// Every row is also appended to a CSV file (one line per resolution, thread count and phase).
+// Build and run with `make bench` (arguments: largest resolution, largest resolution run to convergence, CSV file).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Graph/Graph.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Timing
+    {
+        double seconds { 0.0 }; // median of the calls
+        int calls { 0 };
+    };
+
+    Timing median(std::vector<double>& samples)
+    {
+        std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(samples.size() / 2), samples.end());
+        return Timing{ samples[samples.size() / 2], static_cast<int>(samples.size()) };
+    }
+
+    // median over at least three calls and `minSeconds` of calls in total (the first call is a warm-up)
+    template <typename Call>
+    Timing measure(Call&& call, double minSeconds = 0.2, int maxCalls = 1000)
+    {
+        call();
+        std::vector<double> samples;
+        double total { 0.0 };
+        while (samples.size() < 3 || (total < minSeconds && static_cast<int>(samples.size()) < maxCalls))
+        {
+            auto start { Clock::now() };
+            call();
+            samples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+            total += samples.back();
+        }
+        return median(samples);
+    }
+
+    // median over exactly `calls` calls after a warm-up, for calls that advance the graph: the phases timed after
+    // them then see the same state on every machine and revision
+    template <typename Call>
+    Timing measureSteps(Call&& call, int calls = 20)
+    {
+        call();
+        std::vector<double> samples;
+        for (int k = 0; k < calls; ++k)
+        {
+            auto start { Clock::now() };
+            call();
+            samples.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+        }
+        return median(samples);
+    }
+
+    struct Report
+    {
+        std::ofstream csv;
+
+        // appends, so runs of several revisions end up in one file (each starts with its comment line)
+        explicit Report(const std::string& filename)
+        : csv()
+        {
+            std::error_code error;
+            const bool fresh { !std::filesystem::exists(filename, error) || std::filesystem::file_size(filename, error) == 0 };
+            csv.open(filename, std::ios::app);
+            if (fresh) { csv << "resolution,nodes,edges,threads,phase,calls,seconds" << '\n'; }
+            csv << "# compiler " << __VERSION__ << ", hardware threads " << std::thread::hardware_concurrency() << '\n';
+        }
+
+        void row(const Graph& graph, int threads, const std::string& phase, Timing t, double perUnit, const char* unit)
+        {
+            const unsigned int res { graph.resolution() };
+            csv << res << ',' << res * res << ',' << 2 * res * (res - 1) << ',' << threads << ','
+                << phase << ',' << t.calls << ',' << std::setprecision(6) << t.seconds << '\n';
+            std::cout << std::setw(6) << res << std::setw(4) << threads << "  " << std::left << std::setw(20) << phase << std::right
+                      << std::setw(12) << std::setprecision(4) << t.seconds * 1e3 << " ms" << std::setw(10) << t.calls << " calls"
+                      << std::setw(12) << perUnit * 1e9 << " ns/" << unit << '\n';
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int maxRes { argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 401 };
+    const unsigned int maxConverge { argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 81 };
+    const std::string filename { argc > 3 ? argv[3] : "bench_suite.csv" };
+    const double dt { 0.025 };
+    const double eps { 1e-4 };
+    const unsigned int nSamples { 32 }; // Hessian probes per `sampleHSpec` call
+
+    std::vector<int> threads { 1 };
+    for (int t = 2; t <= static_cast<int>(std::thread::hardware_concurrency()); t *= 2) { threads.push_back(t); }
+
+    Report report(filename);
+    std::cout << std::fixed << "   res thr  phase                   time        calls       per node/edge" << '\n';
+
+    // the graphs announce their seeds on construction
+    std::streambuf* log { std::cout.rdbuf() };
+    auto quiet = [log](bool on) { std::cout.rdbuf(on ? nullptr : log); };
+
+    for (unsigned int res : { 11u, 21u, 41u, 81u, 161u, 401u })
+    {
+        if (res > maxRes) { break; }
+        const double nodes { static_cast<double>(res) * res };
+        const double edges { 2.0 * res * (res - 1) };
+
+        quiet(true);
+        Graph graph(1000, 2.0f, 2.0f, res);
+        Timing construct { measure([res] { Graph g(1000, 2.0f, 2.0f, res); }) };
+        // a few steps in, so the conductances have started to spread
+        for (int i = 0; i < 5; ++i) { graph.evolveGraph(dt); }
+        quiet(false);
+        report.row(graph, 1, "construct", construct, construct.seconds / nodes, "node");
+
+        Timing assemble { measure([&graph] { graph.updateLaplacian(); }) };
+        report.row(graph, 1, "updateLaplacian", assemble, assemble.seconds / edges, "edge");
+
+        // the reduced system `solvePressures` factorizes: L without the grounded node (0 while nothing is pruned)
+        const int N { static_cast<int>(nodes) };
+        Eigen::SparseMatrix<double> Lr { graph.getL().bottomRightCorner(N - 1, N - 1) };
+        Eigen::VectorXd sr { graph.getS().tail(N - 1) }, pr(N - 1);
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt;
+        ldlt.analyzePattern(Lr);
+        Timing factorize { measure([&] { ldlt.factorize(Lr); }) };
+        report.row(graph, 1, "factorize", factorize, factorize.seconds / nodes, "node");
+        Timing solve { measure([&] { pr = ldlt.solve(sr); }) };
+        report.row(graph, 1, "solve", solve, solve.seconds / nodes, "node");
+        Timing pressures { measure([&graph] { graph.solvePressures(); }) };
+        report.row(graph, 1, "solvePressures", pressures, pressures.seconds / nodes, "node");
+
+        Timing flows { measure([&graph] { graph.computeFlows(false); }) };
+        report.row(graph, 1, "computeFlows", flows, flows.seconds / edges, "edge");
+        Timing conductances { measureSteps([&graph, dt] { graph.updateConductances(dt); }) };
+        report.row(graph, 1, "updateConductances", conductances, conductances.seconds / edges, "edge");
+        Timing step { measureSteps([&graph, dt] { graph.evolveGraph(dt); }) };
+        report.row(graph, 1, "evolveGraph", step, step.seconds / nodes, "node");
+
+        // one finite-difference probe (two perturbed solves against the factor of the current state)
+        Timing prepare { measure([&graph] { graph.prepareProbe(); }) };
+        report.row(graph, 1, "prepareProbe", prepare, prepare.seconds / nodes, "node");
+        ProbeWorkspace ws;
+        graph.initProbeWorkspace(ws);
+        std::mt19937 rng(1);
+        Timing probe { measure([&] { graph.probeHessianViaScale(rng, eps, ws); }) };
+        report.row(graph, 1, "probeHessianViaScale", probe, probe.seconds / nodes, "node");
+
+        for (int t : threads)
+        {
+            Timing sample { measure([&graph, t, eps] { graph.sampleHSpec(nSamples, eps, t); }, 0.5, 20) };
+            report.row(graph, t, "sampleHSpec", sample, sample.seconds / (nSamples * nodes), "node/probe");
+        }
+
+        if (res <= maxConverge)
+        {
+            quiet(true);
+            Graph run(1000, 2.0f, 2.0f, res);
+            auto start { Clock::now() };
+            do { run.evolveGraph(dt); } while (!(run.conductanceConverged() && run.fitConverged()));
+            Timing converge { std::chrono::duration<double>(Clock::now() - start).count(), 1 };
+            quiet(false);
+            report.row(run, 1, "converge", converge, converge.seconds / (nodes * static_cast<double>(run.steps())), "node/step");
+        }
+    }
+
+    std::cout << "results written to " << filename << '\n';
+}
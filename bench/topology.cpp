@@ -0,0 +1,86 @@
+// Every topology generator under each node ordering: bandwidth of the numbering and the time per call of the edge
+// gather (`computeFlows`), the Laplacian assembly (`updateLaplacian`), the pressure solve and a whole step.
+// The orderings place the random sources and the conductance noise differently, so the runs are timed over a fixed
+// number of steps rather than to convergence. Build and run with `make bench` (arguments: nodes, steps).
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Graph/Graph.hpp"
+#include "Topology/Topology.hpp"
+
+namespace
+{
+    // microseconds per call of `f`, over `n` calls
+    double perCall(std::size_t n, const std::function<void()>& f)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+        for (std::size_t k = 0; k < n; ++k) { f(); }
+        return 1e6 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(n);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int N { argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 10000 };
+    const std::size_t steps { argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2])) : 10 };
+    const std::size_t repeats { 50 };
+    const float width { 768.0f }, height { 768.0f };
+    const double dt { 0.025 };
+
+    const unsigned int side { static_cast<unsigned int>(std::lround(std::sqrt(N))) };
+    const unsigned int cubeSide { static_cast<unsigned int>(std::lround(std::cbrt(N))) };
+    const std::vector<std::pair<std::string, Topology>> topologies {
+        { "square", Topologies::square(side, width, height) },
+        { "triangular", Topologies::triangular(side, width, height) },
+        { "hexagonal", Topologies::hexagonal(side, width, height) },
+        { "cubic", Topologies::cubic(cubeSide, width, height) },
+        { "geometric", Topologies::randomGeometric(N, 6.0, 1, width, height) },
+        { "delaunay", Topologies::delaunay(N, 1, width, height) },
+    };
+    const std::vector<std::pair<std::string, NodeOrdering>> orderings {
+        { "natural", NodeOrdering::Natural },
+        { "rcm", NodeOrdering::ReverseCuthillMcKee },
+        { "hilbert", NodeOrdering::Hilbert },
+    };
+
+    std::cout << "~" << N << " nodes, " << steps << " steps" << '\n';
+    std::cout << std::left << std::setw(12) << "topology" << std::setw(9) << "order" << std::right << std::setw(8) << "nodes"
+              << std::setw(8) << "edges" << std::setw(10) << "bandwidth" << std::setw(13) << "flows us" << std::setw(13) << "assembly us"
+              << std::setw(13) << "solve us" << std::setw(13) << "step us" << '\n';
+    std::cout << std::fixed << std::setprecision(1);
+
+    // the graphs announce their seeds on construction
+    std::streambuf* log { std::cout.rdbuf(nullptr) };
+    for (const auto& [name, topology] : topologies)
+    {
+        for (const auto& [order, ordering] : orderings)
+        {
+            Topology numbered { topology };
+            const auto start { std::chrono::steady_clock::now() };
+            numbered.reorder(ordering);
+            const double reorderMs { 1e3 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+            Graph graph(12345, numbered);
+            graph.evolveGraph(dt); // analyzes the pattern and factors once
+            const double step { perCall(steps, [&]() { graph.evolveGraph(dt); }) };
+            const double flows { perCall(repeats, [&]() { graph.computeFlows(false); }) };
+            const double assembly { perCall(repeats, [&]() { graph.updateLaplacian(); }) };
+            const double solve { perCall(steps, [&]() { graph.solvePressures(); }) };
+
+            std::cout.rdbuf(log);
+            std::cout << std::left << std::setw(12) << name << std::setw(9) << order << std::right << std::setw(8) << numbered.nodeCount()
+                      << std::setw(8) << numbered.edgeCount() << std::setw(10) << numbered.bandwidth() << std::setw(13) << flows
+                      << std::setw(13) << assembly << std::setw(13) << solve << std::setw(13) << step
+                      << "   (reordered in " << reorderMs << " ms)" << '\n';
+            std::cout.rdbuf(nullptr);
+        }
+    }
+    std::cout.rdbuf(log);
+}
@@ -3,10 +3,12 @@ import matplotlib.pyplot as plt
 import matplotlib.patheffects as pe
 import matplotlib.ticker as ticker
 from scipy.stats import wasserstein_distance
+import resultstore
 
 fs = 16
 resolution = 20
 
+# data = resultstore.spectra(f'./parallel_data_1e-4_many_graphs_{resolution}_clamp_1/store') # binary store written by headless runs
 # data = np.concatenate(tuple(np.loadtxt(f'./parallel_data_1e-4_many_graphs_{resolution}_clamp_1/{8 * j + i}.txt') for i in range(8) for j in range(112))) # cost nonzero
 data = np.concatenate(tuple(np.loadtxt(f'./parallel_data_1e-4_many_graphs_{resolution}_clamp_5/{8 * j + i}.txt') for i in range(8) for j in range(112))) # cost nonzero
 
@@ -0,0 +1,67 @@
+import numpy as np
+import matplotlib.pyplot as plt
+import matplotlib.patheffects as pe
+import sketch
+
+# the density and quantile figures of hist.py, from the sketches a headless sweep writes instead of its raw quotients
+fs = 16
+resolution = 20
+
+header, partitions = sketch.aggregate(f'./parallel_data_1e-4_many_graphs_{resolution}_clamp_5/sketch')
+total = sketch.merge(partitions)
+n = sketch.count(total)
+
+print(total['negative'].sum() / n)
+
+c1 = 'steelblue'
+c2 = 'tab:red'
+c3 = 'tab:orange'
+
+# 10 bins per decade, the width of hist.py's 100 bins over its data range
+edges, positive, negative = sketch.histogram(header, total, 10)
+plt.stairs(positive / n, edges, fill=True, color=c1, alpha=0.85, label='Positive')
+plt.stairs(negative / n, edges, fill=True, color=c3, alpha=0.65, label='Negative')
+plt.yscale('log')
+
+x = np.logspace(-6,2,30)
+plt.plot(np.log10(x), x**-1 * 1e-4, 'k--', label=r'$x^{-1}$ (guide to slope)')
+
+plt.legend(loc='upper right', bbox_to_anchor=(1, 0.97))
+plt.xlabel(r'Rayleigh quotient in $\log_{10}(x)$ $\left[\left(\mathcal{F}^*\right)^{-1}\right]$', fontsize=fs, labelpad=1)
+plt.ylabel('Density', fontsize=fs)
+plt.ylim(top=1e0)
+plt.xlim(-7, 2)
+plt.xticks(np.arange(-7,2))
+
+ax = plt.gca()
+
+# cumulative probability of the positives at the fine bin edges
+fine_edges, fine_positive, _ = sketch.histogram(header, total)
+cumulative = np.cumsum(np.concatenate(([total['underflow'][0]], fine_positive))) / (fine_positive.sum() + total['underflow'][0] + total['overflow'][0])
+ax2 = ax.twinx()
+ax2.plot(fine_edges, cumulative, c=c2, path_effects=[pe.Stroke(linewidth=2, foreground='black'), pe.Normal()])
+ax2.set_ylim(-0.01,1.02)
+ax2.spines["right"].set_color(c2)
+ax2.tick_params(axis='y', colors=c2)
+ax2.set_ylabel('Cumulative probability (positive)', fontsize=fs, color=c2)
+
+# plt.savefig('./figs/HDensity_5.pdf', dpi=500, bbox_inches='tight')
+
+plt.show()
+
+# sample sizes are multiples of one partition (1/16 of the sweep by default), so they start higher than hist.py's
+quantiles = [0.5, 0.9, 0.99]
+n_samples, q_mean, q_std = sketch.quantiles_vs_size(header, partitions, quantiles)
+
+for i in range(len(quantiles)):
+    plt.errorbar(n_samples, q_mean[i,:], yerr=q_std[i,:], marker='.', label=f'{quantiles[i]*100:.0f}%', capsize=4)
+
+plt.xlabel('Sample size', fontsize=fs)
+plt.ylabel('Quantile value', fontsize=fs)
+plt.xscale('log')
+plt.yscale('log')
+
+plt.legend(title='Quantile', title_fontproperties={'weight' : 'bold'})
+# plt.savefig('./figs/quantiles_5.pdf', dpi=500)
+
+plt.show()
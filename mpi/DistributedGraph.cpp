@@ -0,0 +1,562 @@
+#include "DistributedGraph.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <ios>
+#include <map>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    // position of entry (row, col) in the value array of a compressed column-major matrix
+    int slotOf(const Eigen::SparseMatrix<double>& M, int row, int col)
+    {
+        if (row < 0 || col < 0) { return -1; }
+
+        const int* inner { M.innerIndexPtr() };
+        const int* begin { inner + M.outerIndexPtr()[col] };
+        const int* end { inner + M.outerIndexPtr()[col + 1] };
+        const int* it { std::lower_bound(begin, end, row) };
+
+        return (it != end && *it == row) ? static_cast<int>(it - inner) : -1;
+    }
+}
+
+DistributedGraph::DistributedGraph(MPI_Comm comm, uint32_t seed, unsigned int resolution, int overlap, const Parameters& params)
+: m_comm { comm }
+, m_seed { seed }
+, m_n { static_cast<int>(resolution) }
+, m_overlap { overlap }
+, m_params { params }
+, m_policy { EdgeKernel::policy(params.law, params.gamma, params.costExponent) }
+, m_coeffs { params.alpha, params.beta, params.gamma, params.c_t, params.costExponent, params.D_min }
+, m_I0 { 2.0 * static_cast<double>(resolution) / 4.0 }
+{
+    MPI_Comm_rank(m_comm, &m_rank);
+    MPI_Comm_size(m_comm, &m_ranks);
+
+    partition();
+    regularLattice();
+    setSources();
+    buildLocalProblem();
+    buildCoarseProblem();
+}
+
+void DistributedGraph::partition()
+{
+    // neighbours read `overlap` columns past the cut plus the link crossing into it, so every strip needs one more
+    const int width { m_n / m_ranks };
+    if (m_overlap < 0 || width < m_overlap + 1)
+    {
+        throw std::invalid_argument("DistributedGraph: " + std::to_string(m_ranks) + " strips of " + std::to_string(width)
+                                    + " columns are too narrow for an overlap of " + std::to_string(m_overlap));
+    }
+
+    const int extra { m_n % m_ranks };
+    m_x0 = m_rank * width + std::min(m_rank, extra);
+    m_x1 = m_x0 + width + (m_rank < extra ? 1 : 0);
+    m_lo = std::max(0, m_x0 - m_overlap - 1);
+    m_hi = std::min(m_n, m_x1 + std::max(m_overlap, 1));
+    m_e0 = std::max(0, m_x0 - m_overlap);
+    m_e1 = std::min(m_n, m_x1 + m_overlap);
+    if (m_rank > 0) { m_left = m_rank - 1; }
+    if (m_rank < m_ranks - 1) { m_right = m_rank + 1; }
+
+    const std::size_t stored { static_cast<std::size_t>((m_hi - m_lo) * m_n) };
+    m_link.assign(2 * stored, 0.0);
+    m_b.assign(stored, 0.0);
+    m_p.assign(stored, 0.0);
+    m_r.assign(stored, 0.0);
+    m_z.assign(stored, 0.0);
+    m_d.assign(stored, 0.0);
+    m_q.assign(stored, 0.0);
+    m_recv.resize(2 * static_cast<std::size_t>((m_overlap + 1) * m_n));
+
+    // the rows are split like the columns: n / ranks per block, the first n % ranks blocks one taller
+    m_blocks = m_ranks;
+    m_row_block.resize(static_cast<std::size_t>(m_n));
+    for (int J = 0, y = 0; J < m_blocks; ++J)
+    {
+        for (int rows = 0; rows < width + (J < extra ? 1 : 0); ++rows) { m_row_block[static_cast<std::size_t>(y++)] = J; }
+    }
+}
+
+void DistributedGraph::regularLattice()
+{
+    // the generator runs through every edge up to the last owned column, in `Graph::regularLattice`'s order
+    // (the normal distribution caches pairs, so earlier draws cannot be skipped)
+    std::mt19937 rng(m_seed + 2);
+    std::normal_distribution<double> noise(0.0, 2e-1);
+
+    for (int x = 0; x < m_x1; ++x)
+    {
+        for (int y = 0; y < m_n; ++y)
+        {
+            for (int up = 0; up < 2; ++up)
+            {
+                if ((up == 0 && x == m_n - 1) || (up == 1 && y == m_n - 1)) { continue; }
+                const double D { m_params.D0 * (1.0 + noise(rng)) };
+                if (x < m_x0) { continue; }
+
+                m_edges.i.push_back(node(x, y));
+                m_edges.j.push_back(up == 0 ? node(x + 1, y) : node(x, y + 1));
+                m_edge_link.push_back(2 * node(x, y) + up);
+                m_D.push_back(D);
+            }
+        }
+    }
+    m_Q.assign(m_D.size(), 0.0);
+    m_dD.assign(m_D.size(), 0.0);
+
+    for (std::size_t a = 0; a < m_D.size(); ++a) { m_link[static_cast<std::size_t>(m_edge_link[a])] = m_D[a]; }
+    exchange(m_link, m_overlap + 1, m_overlap, 2);
+}
+
+void DistributedGraph::setSources()
+{
+    // `Graph::setSources` on the few nodes that get a source, every rank draws all of them
+    std::mt19937 rng(m_seed + 1);
+    const unsigned int N { static_cast<unsigned int>(m_n * m_n) };
+    const unsigned int sink { static_cast<unsigned int>((m_n + 1) * (m_n - 1) / 2) };
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_int_distribution<unsigned int> dist(0, N - 1);
+
+    std::map<unsigned int, double> s;
+    for (unsigned int i = 0; i < m_params.nSources; ++i)
+    {
+        double s_i { std::abs(normal(rng)) };
+        unsigned int idx { dist(rng) };
+        if (idx != sink)
+        {
+            s[dist(rng)] += s_i;
+        }
+    }
+
+    double sum { 0.0 };
+    for (const auto& [idx, value] : s) { sum += value; }
+    s[sink] = -sum;
+    double norm { 0.0 };
+    for (const auto& [idx, value] : s) { norm += value * value; }
+    norm = std::sqrt(norm);
+
+    for (const auto& [idx, value] : s)
+    {
+        const int x { static_cast<int>(idx) / m_n }, y { static_cast<int>(idx) % m_n };
+        if (x >= m_x0 && x < m_x1 && !grounded(x, y)) { m_b[static_cast<std::size_t>(node(x, y))] = value / norm * m_I0; }
+    }
+}
+
+void DistributedGraph::buildLocalProblem()
+{
+    // rows of the extended strip without the grounded node
+    m_row.assign(m_b.size(), -1);
+    int rows { 0 };
+    for (int x = m_e0; x < m_e1; ++x)
+    {
+        for (int y = 0; y < m_n; ++y)
+        {
+            if (!grounded(x, y)) { m_row[static_cast<std::size_t>(node(x, y))] = rows++; }
+        }
+    }
+    auto row = [this](int x, int y) { return (x < m_e0 || x >= m_e1) ? -1 : m_row[static_cast<std::size_t>(node(x, y))]; };
+
+    // links with at least one end in the strip (those leaving it only add to the diagonal)
+    std::vector<std::array<int, 2>> ends;
+    std::vector<Eigen::Triplet<double>> trips;
+    for (int x = std::max(m_lo, m_e0 - 1); x < m_e1; ++x)
+    {
+        for (int y = 0; y < m_n; ++y)
+        {
+            if (x + 1 < m_n)
+            {
+                m_ext_link.push_back(2 * node(x, y));
+                ends.push_back({ row(x, y), row(x + 1, y) });
+            }
+            if (x >= m_e0 && y + 1 < m_n)
+            {
+                m_ext_link.push_back(2 * node(x, y) + 1);
+                ends.push_back({ row(x, y), row(x, y + 1) });
+            }
+        }
+    }
+    for (const auto& [ri, rj] : ends)
+    {
+        if (ri >= 0) { trips.emplace_back(ri, ri, 0.0); }
+        if (rj >= 0) { trips.emplace_back(rj, rj, 0.0); }
+        if (ri >= 0 && rj >= 0)
+        {
+            trips.emplace_back(ri, rj, 0.0);
+            trips.emplace_back(rj, ri, 0.0);
+        }
+    }
+
+    m_A.resize(rows, rows);
+    m_A.setFromTriplets(trips.begin(), trips.end());
+    m_A.makeCompressed();
+    m_ext_slots.reserve(ends.size());
+    for (const auto& [ri, rj] : ends)
+    {
+        m_ext_slots.push_back(EdgeSlots{ slotOf(m_A, ri, ri), slotOf(m_A, rj, rj), slotOf(m_A, ri, rj), slotOf(m_A, rj, ri) });
+    }
+    m_rhs.resize(rows);
+    m_sol.resize(rows);
+}
+
+void DistributedGraph::buildCoarseProblem()
+{
+    // 5-point pattern over all blocks, identical on every rank so the value arrays can be summed
+    const int strips { m_ranks };
+    const int unknowns { strips * m_blocks };
+    std::vector<Eigen::Triplet<double>> trips;
+    for (int I = 0; I < strips; ++I)
+    {
+        for (int J = 0; J < m_blocks; ++J)
+        {
+            const int k { I * m_blocks + J };
+            trips.emplace_back(k, k, 0.0);
+            if (I + 1 < strips)
+            {
+                trips.emplace_back(k, k + m_blocks, 0.0);
+                trips.emplace_back(k + m_blocks, k, 0.0);
+            }
+            if (J + 1 < m_blocks)
+            {
+                trips.emplace_back(k, k + 1, 0.0);
+                trips.emplace_back(k + 1, k, 0.0);
+            }
+        }
+    }
+    m_coarse.resize(unknowns, unknowns);
+    m_coarse.setFromTriplets(trips.begin(), trips.end());
+    m_coarse.makeCompressed();
+
+    // owned edges end in this strip or, across the cut, in the next one; the grounded node is in no block
+    const int first { m_x0 - m_lo };
+    m_coarse_slots.reserve(m_D.size());
+    for (std::size_t a = 0; a < m_D.size(); ++a)
+    {
+        auto block = [&](int k)
+        {
+            const int x { k / m_n + m_lo }, y { k % m_n };
+            if (grounded(x, y)) { return -1; }
+            return (m_rank + (k / m_n - first >= m_x1 - m_x0 ? 1 : 0)) * m_blocks + m_row_block[static_cast<std::size_t>(y)];
+        };
+        const int bi { block(m_edges.i[a]) }, bj { block(m_edges.j[a]) };
+        if (bi == bj) { m_coarse_slots.push_back(EdgeSlots{ -1, -1, -1, -1 }); }
+        else { m_coarse_slots.push_back(EdgeSlots{ slotOf(m_coarse, bi, bi), slotOf(m_coarse, bj, bj), slotOf(m_coarse, bi, bj), slotOf(m_coarse, bj, bi) }); }
+    }
+    m_coarse_diagonal.clear();
+    for (int k = 0; k < unknowns; ++k) { m_coarse_diagonal.push_back(slotOf(m_coarse, k, k)); }
+    m_coarse_r.assign(static_cast<std::size_t>(unknowns), 0.0);
+    m_coarse_b.resize(unknowns);
+    m_coarse_y.resize(unknowns);
+}
+
+void DistributedGraph::exchange(std::vector<double>& v, int left, int right, int perNode)
+{
+    const std::size_t column { static_cast<std::size_t>(m_n * perNode) };
+    auto at = [&](int x) { return v.data() + static_cast<std::size_t>(x - m_lo) * column; };
+
+    // last columns to the right neighbour's left halo, first columns to the left neighbour's right halo
+    if (left > 0)
+    {
+        const int count { static_cast<int>(static_cast<std::size_t>(left) * column) };
+        MPI_Sendrecv(m_right != MPI_PROC_NULL ? at(m_x1 - left) : v.data(), m_right != MPI_PROC_NULL ? count : 0, MPI_DOUBLE, m_right, 0,
+                     m_left != MPI_PROC_NULL ? at(m_x0 - left) : v.data(), m_left != MPI_PROC_NULL ? count : 0, MPI_DOUBLE, m_left, 0,
+                     m_comm, MPI_STATUS_IGNORE);
+    }
+    if (right > 0)
+    {
+        const int count { static_cast<int>(static_cast<std::size_t>(right) * column) };
+        MPI_Sendrecv(m_left != MPI_PROC_NULL ? at(m_x0) : v.data(), m_left != MPI_PROC_NULL ? count : 0, MPI_DOUBLE, m_left, 1,
+                     m_right != MPI_PROC_NULL ? at(m_x1) : v.data(), m_right != MPI_PROC_NULL ? count : 0, MPI_DOUBLE, m_right, 1,
+                     m_comm, MPI_STATUS_IGNORE);
+    }
+}
+
+void DistributedGraph::accumulate(std::vector<double>& v, int width)
+{
+    if (width == 0) { return; }
+    const std::size_t column { static_cast<std::size_t>(m_n) };
+    const int count { static_cast<int>(static_cast<std::size_t>(width) * column) };
+    auto at = [&](int x) { return v.data() + static_cast<std::size_t>(x - m_lo) * column; };
+    auto add = [&](double* target, int n) { for (int k = 0; k < n; ++k) { target[k] += m_recv[static_cast<std::size_t>(k)]; } };
+
+    // the part beyond the left cut belongs to the last columns of the left neighbour, and the other way round
+    const bool left { m_left != MPI_PROC_NULL }, right { m_right != MPI_PROC_NULL };
+    MPI_Sendrecv(left ? at(m_x0 - width) : v.data(), left ? count : 0, MPI_DOUBLE, m_left, 2,
+                 m_recv.data(), right ? count : 0, MPI_DOUBLE, m_right, 2, m_comm, MPI_STATUS_IGNORE);
+    if (right) { add(at(m_x1 - width), count); }
+    MPI_Sendrecv(right ? at(m_x1) : v.data(), right ? count : 0, MPI_DOUBLE, m_right, 3,
+                 m_recv.data(), left ? count : 0, MPI_DOUBLE, m_left, 3, m_comm, MPI_STATUS_IGNORE);
+    if (left) { add(at(m_x0), count); }
+}
+
+double DistributedGraph::localDot(const std::vector<double>& a, const std::vector<double>& b) const
+{
+    double sum { 0.0 };
+    const std::size_t begin { static_cast<std::size_t>((m_x0 - m_lo) * m_n) }, end { static_cast<std::size_t>((m_x1 - m_lo) * m_n) };
+    for (std::size_t k = begin; k < end; ++k) { sum += a[k] * b[k]; }
+    return sum;
+}
+
+void DistributedGraph::allSum(double* values, int count) const
+{
+    MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, m_comm);
+}
+
+void DistributedGraph::factorize()
+{
+    {
+        PhaseTimer timer(m_telemetry, Phase::Assembly);
+        double* values { m_A.valuePtr() };
+        std::fill(values, values + m_A.nonZeros(), 0.0);
+        for (std::size_t a = 0; a < m_ext_slots.size(); ++a)
+        {
+            const double D { m_link[static_cast<std::size_t>(m_ext_link[a])] };
+            const EdgeSlots& slots { m_ext_slots[a] };
+            if (slots.ii >= 0) { values[slots.ii] += D; }
+            if (slots.jj >= 0) { values[slots.jj] += D; }
+            if (slots.ij >= 0)
+            {
+                values[slots.ij] -= D;
+                values[slots.ji] -= D;
+            }
+        }
+    }
+
+    {
+        PhaseTimer timer(m_telemetry, Phase::Factorization);
+        if (m_steps == 0) { m_solver.analyzePattern(m_A); }
+        m_solver.factorize(m_A);
+        if (m_solver.info() != Eigen::Success)
+        {
+            std::cerr << "Decomposition Failed (rank " << m_rank << ')' << std::endl;
+            ++m_telemetry.failedFactorizations;
+        }
+
+
+        // coarse operator: every rank adds the links between blocks of its edges (sums of conductances, never
+        // differences), then all ranks factorize the same matrix
+        double* values { m_coarse.valuePtr() };
+        std::fill(values, values + m_coarse.nonZeros(), 0.0);
+        for (std::size_t a = 0; a < m_D.size(); ++a)
+        {
+            const EdgeSlots& slots { m_coarse_slots[a] };
+            if (slots.ii >= 0) { values[slots.ii] += m_D[a]; }
+            if (slots.jj >= 0) { values[slots.jj] += m_D[a]; }
+            if (slots.ij >= 0)
+            {
+                values[slots.ij] -= m_D[a];
+                values[slots.ji] -= m_D[a];
+            }
+        }
+        allSum(values, static_cast<int>(m_coarse.nonZeros()));
+        // groups of blocks tied to the grounded one only by links at the floor leave near-null modes that rounding
+        // turns indefinite; a shift relative to the largest diagonal keeps them definite (and their correction small)
+        double largest { 0.0 };
+        for (int slot : m_coarse_diagonal) { largest = std::max(largest, values[slot]); }
+        for (int slot : m_coarse_diagonal) { values[slot] += m_coarse_shift * largest; }
+        if (m_steps == 0) { m_coarse_solver.analyzePattern(m_coarse); }
+        m_coarse_solver.factorize(m_coarse);
+        // every rank factors the same matrix, so all of them take the same decision
+        m_coarse_valid = m_coarse_solver.info() == Eigen::Success && m_coarse_solver.vectorD().minCoeff() > 0.0;
+        if (m_coarse_solver.info() != Eigen::Success) { ++m_telemetry.failedFactorizations; }
+    }
+}
+
+void DistributedGraph::apply(std::vector<double>& v, std::vector<double>& y)
+{
+    // y = L v on the owned rows, in difference form (v is zero on the grounded node)
+    exchange(v, 1, 1);
+    for (int x = m_x0; x < m_x1; ++x)
+    {
+        for (int j = 0; j < m_n; ++j)
+        {
+            const std::size_t k { static_cast<std::size_t>(node(x, j)) };
+            if (grounded(x, j)) { y[k] = 0.0; continue; }
+
+            double sum { 0.0 };
+            if (x > 0) { sum += m_link[2 * (k - static_cast<std::size_t>(m_n))] * (v[k] - v[k - static_cast<std::size_t>(m_n)]); }
+            if (x + 1 < m_n) { sum += m_link[2 * k] * (v[k] - v[k + static_cast<std::size_t>(m_n)]); }
+            if (j > 0) { sum += m_link[2 * (k - 1) + 1] * (v[k] - v[k - 1]); }
+            if (j + 1 < m_n) { sum += m_link[2 * k + 1] * (v[k] - v[k + 1]); }
+            y[k] = sum;
+        }
+    }
+}
+
+void DistributedGraph::precondition(std::vector<double>& r, std::vector<double>& z)
+{
+    // local solves on the overlapping strips, summed where they overlap
+    exchange(r, m_overlap, m_overlap);
+    for (std::size_t k = 0; k < m_row.size(); ++k)
+    {
+        if (m_row[k] >= 0) { m_rhs(m_row[k]) = r[k]; }
+    }
+    m_sol = m_solver.solve(m_rhs);
+    std::fill(z.begin(), z.end(), 0.0);
+    for (std::size_t k = 0; k < m_row.size(); ++k)
+    {
+        if (m_row[k] >= 0) { z[k] = m_sol(m_row[k]); }
+    }
+    accumulate(z, m_overlap);
+    if (!m_use_coarse) { return; }
+
+    // coarse correction, constant over each block
+    const std::size_t own { static_cast<std::size_t>(m_rank * m_blocks) };
+    std::fill(m_coarse_r.begin() + static_cast<std::ptrdiff_t>(own), m_coarse_r.begin() + static_cast<std::ptrdiff_t>(own) + m_blocks, 0.0);
+    for (int x = m_x0; x < m_x1; ++x)
+    {
+        for (int y = 0; y < m_n; ++y) { m_coarse_r[own + static_cast<std::size_t>(m_row_block[static_cast<std::size_t>(y)])] += r[static_cast<std::size_t>(node(x, y))]; }
+    }
+    MPI_Allgather(MPI_IN_PLACE, m_blocks, MPI_DOUBLE, m_coarse_r.data(), m_blocks, MPI_DOUBLE, m_comm);
+    m_coarse_b = Eigen::Map<const Eigen::VectorXd>(m_coarse_r.data(), static_cast<Eigen::Index>(m_coarse_r.size()));
+    m_coarse_y = m_coarse_solver.solve(m_coarse_b);
+
+    for (int x = m_x0; x < m_x1; ++x)
+    {
+        for (int y = 0; y < m_n; ++y)
+        {
+            if (!grounded(x, y)) { z[static_cast<std::size_t>(node(x, y))] += m_coarse_y(static_cast<Eigen::Index>(own) + m_row_block[static_cast<std::size_t>(y)]); }
+        }
+    }
+}
+
+void DistributedGraph::solvePressures()
+{
+    PhaseTimer timer(m_telemetry, Phase::Solve);
+    const double tol { m_D_norm2 > 0.0 ? std::clamp(m_eta * std::sqrt(m_dD_norm2 / m_D_norm2), m_tol_min, m_tol_max) : m_tol_min };
+    const std::size_t begin { static_cast<std::size_t>((m_x0 - m_lo) * m_n) }, end { static_cast<std::size_t>((m_x1 - m_lo) * m_n) };
+
+    // conjugate gradients from the last pressures, stopped on the energy norm of the error as in `Multigrid::solve`;
+    // a breakdown (the preconditioner or the operator no longer definite in floating point) restarts from the current
+    // pressures without the coarse level, a second one fails the solve
+    m_use_coarse = m_coarse_valid;
+    if (!m_use_coarse) { ++m_coarse_fallbacks; }
+    auto residual = [&]()
+    {
+        apply(m_p, m_q);
+        for (std::size_t k = begin; k < end; ++k) { m_r[k] = m_b[k] - m_q[k]; }
+    };
+    residual();
+
+    int its { -1 };
+    double rz { 0.0 };
+    for (int it = 0, restart = 0; it <= m_max_iter; ++it)
+    {
+        precondition(m_r, m_z);
+        std::array<double, 3> dots { localDot(m_r, m_z), localDot(m_b, m_p), localDot(m_r, m_r) };
+        allSum(dots.data(), 3);
+        const double rzNew { dots[0] };
+        if (dots[2] == 0.0 || (rzNew > 0.0 && rzNew <= tol * tol * std::abs(dots[1])))
+        {
+            its = it;
+            break;
+        }
+
+        double dq { 0.0 };
+        if (rzNew > 0.0)
+        {
+            if (it == restart) { std::copy(m_z.begin() + static_cast<std::ptrdiff_t>(begin), m_z.begin() + static_cast<std::ptrdiff_t>(end), m_d.begin() + static_cast<std::ptrdiff_t>(begin)); }
+            else
+            {
+                const double beta { rzNew / rz };
+                for (std::size_t k = begin; k < end; ++k) { m_d[k] = m_z[k] + beta * m_d[k]; }
+            }
+            rz = rzNew;
+
+            apply(m_d, m_q);
+            dq = localDot(m_d, m_q);
+            allSum(&dq, 1);
+        }
+        if (rzNew <= 0.0 || dq <= 0.0)
+        {
+            if (!m_use_coarse) { break; }
+            m_use_coarse = false;
+            ++m_coarse_fallbacks;
+            restart = it + 1;
+            residual();
+            continue;
+        }
+
+        const double alpha { rz / dq };
+        for (std::size_t k = begin; k < end; ++k)
+        {
+            m_p[k] += alpha * m_d[k];
+            m_r[k] -= alpha * m_q[k];
+        }
+    }
+
+    if (its < 0)
+    {
+        if (m_rank == 0) { std::cerr << "Schwarz CG did not converge (step " << m_steps << ')' << std::endl; }
+        ++m_telemetry.failedSolves;
+    }
+    m_last_iterations = (its < 0) ? m_max_iter : its;
+    m_iterations += static_cast<std::size_t>(m_last_iterations);
+
+    // the edges leaving the last owned column need the pressures beyond it
+    exchange(m_p, 0, 1);
+}
+
+void DistributedGraph::evolveGraph(double dt)
+{
+    factorize();
+    solvePressures();
+
+    std::array<double, 4> sums {};
+    {
+        PhaseTimer timer(m_telemetry, Phase::EdgeKernel);
+        const EdgeKernel::Sums local { m_policy.eulerStep(m_edges, m_p.data(), m_D.data(), m_Q.data(), m_dD.data(), m_coeffs, dt) };
+        sums = { local.F, local.F_old, local.dD2, local.D2 };
+        for (std::size_t a = 0; a < m_D.size(); ++a) { m_link[static_cast<std::size_t>(m_edge_link[a])] = m_D[a]; }
+    }
+    allSum(sums.data(), 4);
+    exchange(m_link, m_overlap + 1, m_overlap, 2);
+
+    m_fitness_change = (sums[0] - sums[1]) / sums[1];
+    if (m_fitness_change < m_params.tol) { m_fitness_converged = true; }
+    m_dD_norm2 = sums[2];
+    m_D_norm2 = sums[3];
+
+    ++m_steps;
+    m_telemetry.record(conductanceChange(), m_fitness_change);
+}
+
+double DistributedGraph::conductanceSum() const
+{
+    double sum { 0.0 };
+    for (double D : m_D) { sum += D; }
+    allSum(&sum, 1);
+    return sum;
+}
+
+void DistributedGraph::writeConductances(const std::string& filename) const
+{
+    // full columns hold n east and n - 1 north edges, so the owned edges start at x0 (2 n - 1)
+    MPI_File file;
+    if (MPI_File_open(m_comm, filename.c_str(), MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        throw std::ios_base::failure("Failed to open " + filename);
+    }
+    MPI_File_set_size(file, 0);
+    const MPI_Offset offset { static_cast<MPI_Offset>(m_x0) * (2 * m_n - 1) * static_cast<MPI_Offset>(sizeof(double)) };
+    MPI_File_write_at_all(file, offset, m_D.data(), static_cast<int>(m_D.size()), MPI_DOUBLE, MPI_STATUS_IGNORE);
+    MPI_File_close(&file);
+}
+
+std::vector<double> DistributedGraph::gatherConductances(int root) const
+{
+    // the strips own consecutive ranges of the edge numbering, in rank order
+    const int count { static_cast<int>(m_D.size()) };
+    std::vector<int> counts(m_rank == root ? static_cast<std::size_t>(m_ranks) : 0), offsets(counts.size(), 0);
+    MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, root, m_comm);
+    for (std::size_t k = 1; k < counts.size(); ++k) { offsets[k] = offsets[k - 1] + counts[k - 1]; }
+
+    std::vector<double> D(m_rank == root ? static_cast<std::size_t>(offsets.back() + counts.back()) : 0);
+    MPI_Gatherv(m_D.data(), count, MPI_DOUBLE, D.data(), counts.data(), offsets.data(), MPI_DOUBLE, root, m_comm);
+    return D;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Sparse>
+#include <SparseCholesky>
+
+#include <mpi.h>
+
+#include "Graph/Graph.hpp"
+#include "EdgeKernel/EdgeKernel.hpp"
+#include "Telemetry/Telemetry.hpp"
+
+// One lattice of `Graph::regularLattice` (node x * n + y, edges to x + 1 and y + 1, node 0 grounded) evolved with
+// forward Euler by all ranks of a communicator, for lattices too large for one `SimplicialLDLT`.
+//
+// The lattice is cut into strips of whole columns, one per rank. A rank owns the nodes of its columns and the edges
+// leaving them to the east and north (a contiguous range of `Graph`'s edge numbering), keeps their conductances and
+// runs the fused edge kernel on them; the conductances of the neighbouring columns are mirrored after every step.
+// Seeds reproduce `Graph`: the sources and initial conductances are drawn from the same generators in the same order.
+//
+// Pressures are solved by conjugate gradients preconditioned with two-level additive overlapping Schwarz:
+//   - every rank factorizes (sparse LDL^T) the reduced Laplacian of its strip widened by `overlap` columns on both
+//     sides, held at zero pressure beyond; the local corrections of the overlap are summed by the owners,
+//   - a coarse correction with one unknown per block of rows of a strip (constant over the block; the rows are split
+//     into as many blocks as there are strips, balanced like the columns, so blocks are about as tall as the strips
+//     are wide) carries the long-range part the local solves cannot see. The coarse operator is a 5-point grid over
+//     the blocks whose links are the summed conductances of the edges between two blocks; every rank adds its edges,
+//     and the small system is factorized and solved redundantly on all ranks.
+// The preconditioner is symmetric positive definite, so plain CG applies; one iteration costs one halo exchange
+// for the product, one for the overlap (there and back), and three small collectives. Once groups of blocks are cut
+// off by conductances at the floor, the coarse operator is semidefinite up to rounding, so its diagonal is shifted by
+// a small fraction of its largest entry. Should the factor still not be definite it is not used, and a CG breakdown
+// (r.z or d.Ld not positive) restarts the solve from the current pressures without the coarse level: such solves fall
+// back to one-level Schwarz and never stop on a breakdown.
+// Tolerances follow `Graph`'s iterative solves: energy norm, relative to the change of the conductances.
+class DistributedGraph
+{
+private:
+    MPI_Comm m_comm;
+    int m_rank { 0 }, m_ranks { 1 };
+    int m_left { MPI_PROC_NULL }, m_right { MPI_PROC_NULL };
+
+    uint32_t m_seed;
+    int m_n; // nodes per side
+    int m_overlap;
+    Parameters m_params;
+    const EdgeKernel::Policy& m_policy;
+    EdgeKernel::Coefficients m_coeffs;
+    double m_I0;
+
+    // owned columns [x0, x1), stored columns [lo, hi) (halo: overlap + 1 to the left, max(overlap, 1) to the right),
+    // extended strip of the local solves [e0, e1)
+    int m_x0 { 0 }, m_x1 { 0 }, m_lo { 0 }, m_hi { 0 }, m_e0 { 0 }, m_e1 { 0 };
+
+    // per stored node k: conductance of the link to the east at 2 k, to the north at 2 k + 1 (0 where there is none)
+    std::vector<double> m_link {};
+
+    // owned edges in `Graph` order: endpoints (stored node indices), state and link of each
+    EdgeKernel::Endpoints m_edges {};
+    std::vector<int> m_edge_link {};
+    std::vector<double> m_D {}, m_Q {}, m_dD {};
+
+    // per stored node: sources (owned nodes only) and pressures
+    std::vector<double> m_b {}, m_p {};
+
+    // local problem of the extended strip: row of each stored node (-1 outside or grounded), the links entering it
+    // with their slots in the value array, and its factor
+    std::vector<int> m_row {};
+    std::vector<int> m_ext_link {};
+    std::vector<EdgeSlots> m_ext_slots {};
+    Eigen::SparseMatrix<double> m_A {};
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_solver {};
+    Eigen::VectorXd m_rhs {}, m_sol {};
+
+    // coarse level: `m_blocks` blocks of rows per strip (block J of strip I is unknown I * m_blocks + J), the block of
+    // each row, slots of the owned edges in its value array (-1 for edges inside a block)
+    int m_blocks { 0 };
+    std::vector<int> m_row_block {};
+    std::vector<EdgeSlots> m_coarse_slots {};
+    Eigen::SparseMatrix<double> m_coarse {};
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_coarse_solver {};
+    std::vector<int> m_coarse_diagonal {}; // slot of every diagonal entry
+    double m_coarse_shift { 1e-10 }; // added to the diagonal, relative to its largest entry
+    std::vector<double> m_coarse_r {};
+    Eigen::VectorXd m_coarse_b {}, m_coarse_y {};
+    bool m_coarse_valid { false }; // the last coarse factor is definite
+    bool m_use_coarse { true }; // cleared for the rest of a solve after a breakdown
+    std::size_t m_coarse_fallbacks { 0 }; // solves (or their remainders) without the coarse level
+
+    std::vector<double> m_r {}, m_z {}, m_d {}, m_q {}, m_recv {}; // CG (stored node layout) and halo buffers
+
+    double m_eta { 1e-2 }, m_tol_min { 1e-13 }, m_tol_max { 1e-6 };
+    int m_max_iter { 500 };
+
+    std::size_t m_steps { 0 };
+    std::size_t m_iterations { 0 };
+    int m_last_iterations { 0 };
+    double m_dD_norm2 { 0.0 }, m_D_norm2 { 0.0 };
+    double m_fitness_change { 0.0 };
+    bool m_fitness_converged { false };
+    Telemetry m_telemetry {};
+
+    int node(int x, int y) const { return (x - m_lo) * m_n + y; }
+    bool grounded(int x, int y) const { return x == 0 && y == 0; }
+
+    void partition();
+    void regularLattice();
+    void setSources();
+    void buildLocalProblem();
+    void buildCoarseProblem();
+
+    // fills the columns [x0 - left, x0) from the left neighbour and [x1, x1 + right) from the right one
+    // (`perNode` values per stored node)
+    void exchange(std::vector<double>& v, int left, int right, int perNode = 1);
+    // adds the values of the `width` columns beyond either end of the strip to the neighbours owning them
+    void accumulate(std::vector<double>& v, int width);
+    double localDot(const std::vector<double>& a, const std::vector<double>& b) const; // over the owned nodes
+    void allSum(double* values, int count) const;
+
+    void factorize();
+    void apply(std::vector<double>& v, std::vector<double>& y);
+    void precondition(std::vector<double>& r, std::vector<double>& z);
+    void solvePressures();
+
+public:
+    // collective: every rank of `comm` constructs its strip
+    DistributedGraph(MPI_Comm comm, uint32_t seed, unsigned int resolution, int overlap = 4, const Parameters& params = Parameters{});
+    DistributedGraph(const DistributedGraph&) = delete;
+    DistributedGraph& operator=(const DistributedGraph&) = delete;
+
+    // collective
+    void evolveGraph(double dt);
+    bool conductanceConverged() const { return sqrt(m_dD_norm2 / m_D_norm2) < m_params.tol; }
+    bool fitConverged() const { return m_fitness_converged; }
+    // collective: sum of all conductances
+    double conductanceSum() const;
+    // collective: conductances of every edge in `Graph` order, as raw float64 (MPI-IO, each rank writes its range)
+    void writeConductances(const std::string& filename) const;
+    // collective: conductances of every edge in `Graph` order on `root` (empty on the other ranks)
+    std::vector<double> gatherConductances(int root = 0) const;
+
+    void setSolveTolerance(double eta, double tolMin = 1e-13, double tolMax = 1e-6) { m_eta = eta; m_tol_min = tolMin; m_tol_max = tolMax; }
+
+    std::size_t steps() const { return m_steps; }
+    std::size_t iterations() const { return m_iterations; }
+    std::size_t coarseFallbacks() const { return m_coarse_fallbacks; }
+    int lastIterations() const { return m_last_iterations; }
+    double conductanceChange() const { return sqrt(m_dD_norm2 / m_D_norm2); }
+    double fitnessChange() const { return m_fitness_change; }
+    const Telemetry& telemetry() const { return m_telemetry; }
+    int rank() const { return m_rank; }
+    int ranks() const { return m_ranks; }
+    int ownedColumns() const { return m_x1 - m_x0; }
+};
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Agreement of the domain-decomposed solver with the serial `Graph` (step counts and conductances), including
+# strips and row blocks of uneven width. Exits non-zero on the first mismatch.
+# Usage: mpi/check.sh [seed] (run `make mpi` first)
+
+SEED=${1:-12345}
+BIN=${BIN:-build/mpi/lattice}
+
+for RUN in "41 1" "41 2" "41 3" "61 2" "61 4"; do
+    set -- $RUN
+    echo "resolution $1 on $2 ranks"
+    OUT=$(mpirun -np "$2" "$BIN" --check "$1" 2 "$SEED" 0)
+    STATUS=$?
+    echo "$OUT" | tail -n 1
+    [ "$STATUS" -eq 0 ] || exit 1
+done
@@ -0,0 +1,122 @@
+// One large lattice evolved to its steady state by all ranks of MPI_COMM_WORLD (see `DistributedGraph`).
+// Build with `make mpi`, run with
+//     mpirun -np <ranks> build/mpi/lattice [--check] [resolution] [overlap] [seed] [max steps, 0 = until converged] [output file]
+// The last line is a CSV record (ranks, resolution, steps, CG iterations, seconds) for strong scaling runs,
+// see `mpi/scaling.sh`. With an output file, the final conductances are written in `Graph`'s edge order (raw float64).
+// With --check, rank 0 then evolves the same lattice with the serial `Graph` and compares the step counts and the
+// conductances, failing on a mismatch (see `mpi/check.sh`).
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <mpi.h>
+
+#include "DistributedGraph.hpp"
+
+int main(int argc, char* argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank { 0 }, ranks { 1 };
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    const bool check { argc > 1 && std::string_view(argv[1]) == "--check" };
+    if (check)
+    {
+        --argc;
+        ++argv;
+    }
+    const unsigned int resolution { argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 401 };
+    const int overlap { argc > 2 ? std::atoi(argv[2]) : 4 };
+    const uint32_t seed { argc > 3 ? static_cast<uint32_t>(std::atoll(argv[3])) : 12345 };
+    const std::size_t maxSteps { argc > 4 ? static_cast<std::size_t>(std::atoll(argv[4])) : 0 };
+    const std::string output { argc > 5 ? argv[5] : "" };
+    const double dt { 0.025 };
+    const std::size_t reportInterval { 50 };
+    // the iterative solves stop on a relative tolerance, the direct serial one does not
+    const double checkTolerance { 1e-6 };
+    bool matches { true };
+
+    try
+    {
+        auto start { std::chrono::steady_clock::now() };
+        DistributedGraph graph(MPI_COMM_WORLD, seed, resolution, overlap);
+        const double setup { std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+        if (rank == 0)
+        {
+            std::cout << "Graph init seed : " << seed << ", resolution " << resolution << ", " << ranks << " ranks ("
+                      << graph.ownedColumns() << " columns on rank 0), overlap " << overlap << '\n';
+        }
+
+        start = std::chrono::steady_clock::now();
+        do
+        {
+            graph.evolveGraph(dt);
+            if (rank == 0 && graph.steps() % reportInterval == 0)
+            {
+                std::cout << "step " << graph.steps() << " : |dD|/|D| " << graph.conductanceChange() << ", dF/F " << graph.fitnessChange()
+                          << ", " << graph.lastIterations() << " iterations" << '\n';
+            }
+        } while (!(graph.conductanceConverged() && graph.fitConverged()) && (maxSteps == 0 || graph.steps() < maxSteps));
+        const double seconds { std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+        const double Dsum { graph.conductanceSum() };
+        if (!output.empty()) { graph.writeConductances(output); }
+
+        // slowest rank per phase
+        std::array<double, static_cast<std::size_t>(Phase::Count)> phases { graph.telemetry().seconds };
+        MPI_Reduce(rank == 0 ? MPI_IN_PLACE : phases.data(), phases.data(), static_cast<int>(phases.size()), MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+        if (rank == 0)
+        {
+            const bool converged { graph.conductanceConverged() && graph.fitConverged() };
+            std::cout << (converged ? "Converged!" : "Stopped") << " (" << graph.steps() << " steps, " << graph.iterations() << " iterations, "
+                      << std::setprecision(4) << static_cast<double>(graph.iterations()) / static_cast<double>(graph.steps()) << " per solve)" << '\n';
+            std::cout << std::setprecision(16) << "sum of conductances " << Dsum << '\n' << std::setprecision(4);
+            std::cout << "setup " << setup << " s, evolution " << seconds << " s (" << seconds / static_cast<double>(graph.steps()) << " s/step)" << '\n';
+            for (std::size_t k = 0; k < phases.size(); ++k)
+            {
+                if (phases[k] > 0.0) { std::cout << std::setw(15) << Telemetry::names[k] << " : " << phases[k] << " s (slowest rank)" << '\n'; }
+            }
+            std::cout << "ranks,resolution,steps,iterations,seconds" << '\n'
+                      << ranks << ',' << resolution << ',' << graph.steps() << ',' << graph.iterations() << ',' << seconds << std::endl;
+            if (graph.coarseFallbacks() > 0) { std::cout << graph.coarseFallbacks() << " solves without the coarse level" << std::endl; }
+        }
+
+        const std::vector<double> D { check ? graph.gatherConductances() : std::vector<double> {} };
+        if (check && rank == 0)
+        {
+            Graph serial(seed, 768.0f, 768.0f, resolution);
+            do { serial.evolveGraph(dt); } while (!(serial.conductanceConverged() && serial.fitConverged()) && (maxSteps == 0 || serial.steps() < maxSteps));
+
+            const Eigen::VectorXd& reference { serial.getD() };
+            const bool sameEdges { D.size() == static_cast<std::size_t>(reference.size()) };
+            double diff { 0.0 };
+            for (std::size_t k = 0; sameEdges && k < D.size(); ++k) { diff = std::max(diff, std::abs(D[k] - reference(static_cast<Eigen::Index>(k)))); }
+            diff /= reference.cwiseAbs().maxCoeff();
+            matches = sameEdges && serial.steps() == graph.steps() && diff < checkTolerance;
+            std::cout << "serial Graph: " << serial.steps() << " steps, largest conductance difference " << std::setprecision(3) << diff
+                      << " of the largest conductance: " << (matches ? "match" : "MISMATCH") << std::endl;
+        }
+        MPI_Bcast(&matches, 1, MPI_CXX_BOOL, 0, MPI_COMM_WORLD);
+    }
+    catch (const std::exception& e)
+    {
+        // the partition is checked identically on every rank
+        if (rank == 0) { std::cerr << e.what() << std::endl; }
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    MPI_Finalize();
+    return matches ? 0 : EXIT_FAILURE;
+}
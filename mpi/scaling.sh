@@ -0,0 +1,16 @@
+#!/bin/sh
+# Strong scaling of the domain-decomposed solver: the same lattice and number of steps on 1, 2, 4, ... ranks
+# (up to the core count), with the speedup and parallel efficiency against one rank.
+# Usage: mpi/scaling.sh [resolution] [steps] [largest rank count] (run `make mpi` first)
+
+RES=${1:-2001}
+STEPS=${2:-20}
+MAX=${3:-$(getconf _NPROCESSORS_ONLN)}
+BIN=${BIN:-build/mpi/lattice}
+
+echo "ranks,resolution,steps,iterations,seconds,speedup,efficiency"
+P=1
+while [ "$P" -le "$MAX" ]; do
+    mpirun -np "$P" "$BIN" "$RES" 4 12345 "$STEPS" | tail -n 1
+    P=$((P * 2))
+done | awk -F, '{ if (NR == 1) { t1 = $5 } printf "%s,%.2f,%.2f\n", $0, t1 / $5, t1 / $5 / $1 }'
@@ -1,8 +1,16 @@
+import os
 import numpy as np
 import matplotlib.pyplot as plt
+from trajectory import load_trajectory
 
-D = np.loadtxt("conductances.txt", delimiter=',')
-Dl = np.loadtxt("conductances_largeInit.txt", delimiter=',')
+def load_conductances(name):
+    # prefer the binary recorder output, fall back to the old CSV rows
+    if os.path.exists(name + '.traj'):
+        return load_trajectory(name + '.traj')[1]
+    return np.loadtxt(name + '.txt', delimiter=',')
+
+D = load_conductances("conductances")
+Dl = load_conductances("conductances_largeInit")
 
 fs = 16
 
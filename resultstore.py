@@ -0,0 +1,72 @@
+import os
+import numpy as np
+
+# mirrors `ResultRecord` in src/ResultStore/ResultStore.hpp (native little-endian)
+record_dtype = np.dtype([
+    ('id', '<u8'),
+    ('offset', '<u8'),
+    ('count', '<u8'),
+    ('steps', '<u8'),
+    ('seed', '<u4'),
+    ('resolution', '<u4'),
+    ('kind', '<u4'),
+    ('n_sources', '<u4'),
+    ('law', '<u4'),
+    ('reserved', '<u4'),
+    ('dt', '<f8'),
+    ('eps', '<f8'),
+    ('D0', '<f8'),
+    ('tol', '<f8'),
+    ('D_min', '<f8'),
+    ('c_t', '<f8'),
+    ('alpha', '<f8'),
+    ('beta', '<f8'),
+    ('gamma', '<f8'),
+    ('cost_exponent', '<f8'),
+])
+assert record_dtype.itemsize == 136
+
+RAYLEIGH_QUOTIENTS = 0
+LANCZOS_QUADRATURE = 1
+
+HEADER_SIZE = 16
+
+
+def _memmap(path, magic, dtype):
+    with open(path, 'rb') as f:
+        if f.read(8) != magic:
+            raise ValueError(f'{path} is not a result store file')
+    n = (os.path.getsize(path) - HEADER_SIZE) // dtype.itemsize
+    if n <= 0:
+        return np.zeros(0, dtype=dtype)
+    return np.memmap(path, dtype=dtype, mode='r', offset=HEADER_SIZE, shape=(n,))
+
+
+def load(directory):
+    """Memory-map a result store, returns (meta, values).
+
+    `meta` is a structured array with one row per graph; the values of row r are
+    `values[r['offset'] : r['offset'] + r['count']]`.
+    """
+    meta = _memmap(os.path.join(directory, 'meta.bin'), b'TKNMETA2', record_dtype)
+    values = _memmap(os.path.join(directory, 'values.bin'), b'TKNVALS1', np.dtype('<f8'))
+    # a writer appends values before their record, so complete records never point past the end
+    meta = meta[meta['offset'] + meta['count'] <= len(values)]
+    # a sweep interrupted between storing a result and marking its task done stores it again on restart:
+    # keep the last record of every task, seed, kind and eps
+    key = np.stack([meta['id'], meta['seed'], meta['kind'], meta['eps'].view('<u8')], axis=1) if len(meta) else np.zeros((0, 4), '<u8')
+    _, last = np.unique(key[::-1], axis=0, return_index=True)
+    meta = meta[np.sort(len(meta) - 1 - last)]
+    return meta, values
+
+
+def spectra(directory, kind=RAYLEIGH_QUOTIENTS, **where):
+    """Concatenate the values of every record of `kind` whose metadata matches `where` (e.g. resolution=41)."""
+    meta, values = load(directory)
+    mask = meta['kind'] == kind
+    for key, value in where.items():
+        mask &= meta[key] == value
+    rows = meta[mask]
+    if len(rows) == 0:
+        return np.zeros(0)
+    return np.concatenate([values[r['offset']:r['offset'] + r['count']] for r in rows])
@@ -0,0 +1,123 @@
+import os
+import numpy as np
+
+# mirrors the sketch files of src/Sketch/Sketch.cpp (native little-endian)
+header_dtype = np.dtype([
+    ('magic', 'S8'),
+    ('bins_per_decade', '<u4'),
+    ('min_exp', '<i4'),
+    ('max_exp', '<i4'),
+    ('partitions', '<u4'),
+    ('reserved', '<u8'),
+])
+assert header_dtype.itemsize == 32
+
+
+def _partition_dtype(bins):
+    return np.dtype([
+        ('zero', '<u8'),
+        ('underflow', '<u8', 2), # positive, negative
+        ('overflow', '<u8', 2),
+        ('reserved', '<u8'),
+        ('min', '<f8'),
+        ('max', '<f8'),
+        ('positive', '<u8', bins),
+        ('negative', '<u8', bins),
+    ])
+
+
+def load(path):
+    """Read a sketch file (`aggregate.sketch`, or one of `parts/`), returns (header, partitions).
+
+    `partitions` is a structured array with one row per partition; bin k of `positive` (`negative`) counts the values
+    x (-x) in [10^(min_exp + k / bins_per_decade), 10^(min_exp + (k + 1) / bins_per_decade)).
+    """
+    header = np.fromfile(path, dtype=header_dtype, count=1)[0]
+    if header['magic'] != b'TKNSKCH1':
+        raise ValueError(f'{path} is not a sketch file')
+    bins = (int(header['max_exp']) - int(header['min_exp'])) * int(header['bins_per_decade'])
+    partitions = np.fromfile(path, dtype=_partition_dtype(bins), count=int(header['partitions']), offset=header_dtype.itemsize)
+    return header, partitions
+
+
+def merge(partitions):
+    """Sum partitions (e.g. a subset of `load(path)[1]`) into one sketch."""
+    return {
+        'zero': partitions['zero'].sum(),
+        'underflow': partitions['underflow'].sum(axis=0),
+        'overflow': partitions['overflow'].sum(axis=0),
+        'min': partitions['min'].min(),
+        'max': partitions['max'].max(),
+        'positive': partitions['positive'].sum(axis=0),
+        'negative': partitions['negative'].sum(axis=0),
+    }
+
+
+def count(sketch):
+    return int(sketch['positive'].sum() + sketch['negative'].sum() + sketch['underflow'].sum() + sketch['overflow'].sum() + sketch['zero'])
+
+
+def histogram(header, sketch, bins_per_decade=None):
+    """log10 bin edges and the positive and negative counts, rebinned to `bins_per_decade` (a divisor of the sketch's)."""
+    fine = int(header['bins_per_decade'])
+    factor = fine // (bins_per_decade or fine)
+    if factor < 1 or fine % factor != 0:
+        raise ValueError(f'{bins_per_decade} bins per decade do not divide the sketch bins ({fine} per decade)')
+    positive = sketch['positive'].reshape(-1, factor).sum(axis=1)
+    negative = sketch['negative'].reshape(-1, factor).sum(axis=1)
+    edges = int(header['min_exp']) + np.arange(len(positive) + 1) * factor / fine
+    return edges, positive, negative
+
+
+def quantile(header, sketch, q, positive_only=False):
+    """Approximate quantile(s) `q`, the geometric center of the bin holding the nearest order statistic (as in `LogSketch`)."""
+    fine = int(header['bins_per_decade'])
+    centers = 10.0**(int(header['min_exp']) + (np.arange(len(sketch['positive'])) + 0.5) / fine)
+    smallest = 10.0**int(header['min_exp'])
+    # ascending order of value
+    values = np.concatenate(([smallest], centers, [sketch['max']]))
+    counts = np.concatenate(([sketch['underflow'][0]], sketch['positive'], [sketch['overflow'][0]]))
+    if not positive_only:
+        values = np.concatenate(([sketch['min']], -centers[::-1], [-smallest, 0.0], values))
+        counts = np.concatenate(([sketch['overflow'][1]], sketch['negative'][::-1], [sketch['underflow'][1], sketch['zero']], counts))
+    n = counts.sum()
+    if n == 0:
+        return np.full(np.shape(q), np.nan)
+    rank = np.floor(np.clip(q, 0.0, 1.0) * (n - 1) + 0.5)
+    return values[np.searchsorted(np.cumsum(counts), rank, side='right')]
+
+
+def quantiles_vs_size(header, partitions, quantiles, n_trials=50, seed=0):
+    """Quantiles of the positive values over merges of 1, 2, 4, ... random partitions, the stand-in for resampling raw data.
+
+    Returns (sample sizes, mean, std), the last two of shape (len(quantiles), number of sizes).
+    """
+    rng = np.random.default_rng(seed)
+    sizes = 2**np.arange(int(np.log2(len(partitions))) + 1)
+    n_samples = np.zeros(len(sizes))
+    q_mean = np.zeros((len(quantiles), len(sizes)))
+    q_std = np.zeros((len(quantiles), len(sizes)))
+    per_partition = (partitions['positive'].sum(axis=1) + partitions['underflow'][:, 0] + partitions['overflow'][:, 0]).mean()
+    for i, m in enumerate(sizes):
+        trials = np.array([quantile(header, merge(partitions[rng.choice(len(partitions), size=m, replace=False)]), quantiles, positive_only=True)
+                           for _ in range(n_trials)])
+        n_samples[i] = m * per_partition
+        q_mean[:, i] = trials.mean(axis=0)
+        q_std[:, i] = trials.std(axis=0)
+    return n_samples, q_mean, q_std
+
+
+def aggregate(directory):
+    """Load `aggregate.sketch` of a sweep, or merge its `parts/` if the sweep has not written one yet."""
+    path = os.path.join(directory, 'aggregate.sketch')
+    if os.path.exists(path):
+        return load(path)
+    parts = [load(os.path.join(directory, 'parts', f)) for f in sorted(os.listdir(os.path.join(directory, 'parts'))) if f.endswith('.sketch')]
+    header = parts[0][0]
+    partitions = parts[0][1].copy()
+    for _, p in parts[1:]:
+        for field in ('zero', 'underflow', 'overflow', 'positive', 'negative'):
+            partitions[field] += p[field]
+        partitions['min'] = np.minimum(partitions['min'], p['min'])
+        partitions['max'] = np.maximum(partitions['max'], p['max'])
+    return header, partitions
@@ -0,0 +1,341 @@
+#include "Checkpoint.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <sstream>
+
+#include "../Utilities/Utilities.hpp"
+
+namespace
+{
+    constexpr char stateMagic[9] { "TKNSTAT3" };
+
+    void append(std::vector<char>& buffer, const void* data, std::size_t size)
+    {
+        const char* bytes { static_cast<const char*>(data) };
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void appendText(std::vector<char>& buffer, const std::string& text)
+    {
+        uint64_t size { text.size() };
+        append(buffer, &size, sizeof(size));
+        append(buffer, text.data(), text.size());
+    }
+
+    template <typename Engine>
+    std::string engineState(const Engine& engine)
+    {
+        std::ostringstream os;
+        os << engine;
+        return os.str();
+    }
+
+    // sequential reads from a loaded file, throwing on a short file
+    struct Reader
+    {
+        const std::vector<char>& bytes;
+        const std::string& filename;
+        std::size_t pos { 0 };
+
+        void read(void* data, std::size_t size)
+        {
+            if (size > bytes.size() - pos) { throw std::ios_base::failure(filename + " is truncated"); }
+            std::memcpy(data, bytes.data() + pos, size);
+            pos += size;
+        }
+
+        std::string text()
+        {
+            uint64_t size { 0 };
+            read(&size, sizeof(size));
+            if (size > bytes.size() - pos) { throw std::ios_base::failure(filename + " is truncated"); }
+            std::string t(bytes.data() + pos, static_cast<std::size_t>(size));
+            pos += static_cast<std::size_t>(size);
+            return t;
+        }
+    };
+}
+
+StateHeader Checkpoint::header(const Graph& graph, double dt)
+{
+    const Parameters params { graph.parameters() };
+    const IntegratorStats& stats { graph.m_stats };
+
+    StateHeader h;
+    std::memcpy(h.magic, stateMagic, 8);
+    h.version = static_cast<uint32_t>(stateMagic[7] - '0'); // the magic ends in the format version
+    h.seed = graph.m_master_seed;
+    h.resolution = graph.m_resolution;
+    h.nSources = params.nSources;
+    h.law = static_cast<uint32_t>(params.law);
+    h.integrator = static_cast<uint32_t>(graph.m_integrator);
+    h.groundIdx = graph.m_ground_idx;
+    h.converged = (graph.conductanceConverged() ? 1u : 0u) | (graph.fitnessConverged ? 2u : 0u);
+    h.factorValid = graph.m_factor_valid ? 1u : 0u;
+    h.nodes = graph.m_nodes.size();
+    h.edges = graph.m_edges.size();
+    h.aliveEdges = graph.m_alive_edges.size();
+    h.steps = graph.m_steps;
+    h.acceptedSteps = stats.steps;
+    h.rejectedSteps = stats.rejected;
+    h.solves = stats.solves;
+    h.factorizations = stats.factorizations;
+    h.iterations = stats.iterations;
+    h.history = graph.m_telemetry.conductanceHistory.size();
+    h.dt = dt;
+    h.time = stats.time;
+    h.h = stats.h;
+    h.lastH = stats.lastH;
+    h.E_prev = graph.m_E_prev;
+    h.D0 = params.D0;
+    h.tol = params.tol;
+    h.D_min = params.D_min;
+    h.c_t = params.c_t;
+    h.alpha = params.alpha;
+    h.beta = params.beta;
+    h.gamma = params.gamma;
+    h.costExponent = params.costExponent;
+    return h;
+}
+
+bool Checkpoint::matches(const StateHeader& h, const Graph& graph)
+{
+    const Parameters params { graph.parameters() };
+    return h.seed == graph.m_master_seed && h.resolution == graph.m_resolution
+        && h.nodes == graph.m_nodes.size() && h.edges == graph.m_edges.size()
+        && h.nSources == params.nSources && h.law == static_cast<uint32_t>(params.law)
+        && h.integrator == static_cast<uint32_t>(graph.m_integrator)
+        && h.D0 == params.D0 && h.tol == params.tol && h.D_min == params.D_min && h.c_t == params.c_t
+        && h.alpha == params.alpha && h.beta == params.beta && h.gamma == params.gamma
+        && h.costExponent == params.costExponent;
+}
+
+void Checkpoint::save(const std::string& filename, const Graph& graph, double dt)
+{
+    const StateHeader h { header(graph, dt) };
+    const std::size_t E { graph.m_edges.size() }, N { graph.m_nodes.size() };
+
+    std::vector<char> buffer;
+    buffer.reserve(sizeof(h) + (5 * E + 2 * N) * sizeof(double) + graph.m_alive_edges.size() * sizeof(uint32_t) + 16384);
+    append(buffer, &h, sizeof(h));
+    appendText(buffer, engineState(graph.m_rng_sources));
+    appendText(buffer, engineState(graph.m_rng_initD));
+    append(buffer, graph.Dvec.data(), E * sizeof(double));
+    append(buffer, graph.dDvec.data(), E * sizeof(double));
+    append(buffer, graph.Qvec.data(), E * sizeof(double));
+    append(buffer, graph.m_dead_since.data(), E * sizeof(double));
+    append(buffer, graph.s.data(), N * sizeof(double));
+    append(buffer, graph.p.data(), N * sizeof(double));
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t));
+    append(buffer, graph.m_alive_edges.data(), graph.m_alive_edges.size() * sizeof(uint32_t));
+    if (h.factorValid) { append(buffer, graph.m_D_factored.data(), E * sizeof(double)); }
+    const Telemetry& telemetry { graph.m_telemetry };
+    const uint64_t failed[2] { telemetry.failedFactorizations, telemetry.failedSolves };
+    static_assert(sizeof(std::size_t) == sizeof(uint64_t));
+    append(buffer, telemetry.seconds.data(), sizeof(telemetry.seconds));
+    append(buffer, telemetry.calls.data(), sizeof(telemetry.calls));
+    append(buffer, failed, sizeof(failed));
+    append(buffer, telemetry.conductanceHistory.data(), telemetry.conductanceHistory.size() * sizeof(double));
+    append(buffer, telemetry.fitnessHistory.data(), telemetry.fitnessHistory.size() * sizeof(double));
+
+    // write next to the target and rename over it, so the previous state survives a crash in between
+    Utilities::replaceSynced(filename, std::string_view(buffer.data(), buffer.size()));
+}
+
+bool Checkpoint::load(const std::string& filename, Graph& graph, double dt)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) { return false; }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Reader in { bytes, filename };
+    StateHeader h;
+    in.read(&h, sizeof(h));
+    if (std::memcmp(h.magic, stateMagic, 7) != 0) { throw std::ios_base::failure(filename + " is not a state file"); }
+    // states of other format versions are evolved again
+    if (h.magic[7] != stateMagic[7]) { return false; }
+    if (!matches(h, graph) || (dt > 0.0 && h.dt != dt)) { return false; }
+
+    const std::size_t E { static_cast<std::size_t>(h.edges) }, N { static_cast<std::size_t>(h.nodes) };
+    std::istringstream sources { in.text() };
+    std::istringstream initD { in.text() };
+    const std::size_t H { static_cast<std::size_t>(h.history) };
+    Telemetry& telemetry { graph.m_telemetry };
+    if (bytes.size() - in.pos != ((h.factorValid ? 5 : 4) * E + 2 * N + 2 * H) * sizeof(double) + static_cast<std::size_t>(h.aliveEdges) * sizeof(uint32_t)
+                                     + sizeof(telemetry.seconds) + sizeof(telemetry.calls) + 2 * sizeof(uint64_t))
+    {
+        throw std::ios_base::failure(filename + " has the wrong size");
+    }
+    in.read(graph.Dvec.data(), E * sizeof(double));
+    in.read(graph.dDvec.data(), E * sizeof(double));
+    in.read(graph.Qvec.data(), E * sizeof(double));
+    in.read(graph.m_dead_since.data(), E * sizeof(double));
+    in.read(graph.s.data(), N * sizeof(double));
+    in.read(graph.p.data(), N * sizeof(double));
+    graph.m_alive_edges.resize(static_cast<std::size_t>(h.aliveEdges));
+    in.read(graph.m_alive_edges.data(), graph.m_alive_edges.size() * sizeof(uint32_t));
+    if (h.factorValid)
+    {
+        graph.m_D_factored.resize(static_cast<Eigen::Index>(E));
+        in.read(graph.m_D_factored.data(), E * sizeof(double));
+    }
+    uint64_t failed[2] {};
+    in.read(telemetry.seconds.data(), sizeof(telemetry.seconds));
+    in.read(telemetry.calls.data(), sizeof(telemetry.calls));
+    in.read(failed, sizeof(failed));
+    telemetry.failedFactorizations = static_cast<std::size_t>(failed[0]);
+    telemetry.failedSolves = static_cast<std::size_t>(failed[1]);
+    telemetry.conductanceHistory.resize(H);
+    telemetry.fitnessHistory.resize(H);
+    in.read(telemetry.conductanceHistory.data(), H * sizeof(double));
+    in.read(telemetry.fitnessHistory.data(), H * sizeof(double));
+    sources >> graph.m_rng_sources;
+    initD >> graph.m_rng_initD;
+
+    graph.m_steps = static_cast<std::size_t>(h.steps);
+    graph.m_stats.steps = static_cast<std::size_t>(h.acceptedSteps);
+    graph.m_stats.rejected = static_cast<std::size_t>(h.rejectedSteps);
+    graph.m_stats.solves = static_cast<std::size_t>(h.solves);
+    graph.m_stats.factorizations = static_cast<std::size_t>(h.factorizations);
+    graph.m_stats.iterations = static_cast<std::size_t>(h.iterations);
+    graph.m_stats.time = h.time;
+    graph.m_stats.h = h.h;
+    graph.m_stats.lastH = h.lastH;
+    graph.m_E_prev = h.E_prev;
+    graph.fitnessConverged = (h.converged & 2u) != 0;
+
+    // the reduced system follows the pruned edges and the grounded node
+    graph.m_ground_idx = h.groundIdx;
+    graph.numberReducedSystem();
+    graph.fillReducedSources();
+    graph.buildLaplacianPattern();
+    if (h.factorValid)
+    {
+        // the reused factor is refactored from the conductances it was taken at, so the pressures (refined against it)
+        // continue exactly as in the uninterrupted run
+        graph.assembleReduced(graph.m_D_factored, graph.Lr);
+        graph.solver.analyzePattern(graph.Lr);
+        graph.solverInitialized = true;
+        graph.solver.factorize(graph.Lr);
+        graph.m_factor_valid = graph.solver.info() == Eigen::Success;
+    }
+    graph.updateLaplacian();
+    graph.gatherPressures(graph.p, graph.pr);
+    graph.updateNorms();
+    graph.m_fsal = false;
+    graph.m_probe_ready = false;
+    return true;
+}
+
+StateStore::StateStore(const std::string& directory)
+: m_directory { directory }
+{
+    std::filesystem::create_directories(m_directory);
+}
+
+std::string StateStore::parameterHash(const Parameters& params, const EvolutionSettings& settings, double dt)
+{
+    // FNV-1a over the parameters in declaration order and the step
+    uint64_t hash { 14695981039346656037ull };
+    auto mix = [&hash](const void* data, std::size_t size)
+    {
+        const unsigned char* bytes { static_cast<const unsigned char*>(data) };
+        for (std::size_t i = 0; i < size; ++i) { hash = (hash ^ bytes[i]) * 1099511628211ull; }
+    };
+    const uint32_t law { static_cast<uint32_t>(params.law) };
+    mix(&params.nSources, sizeof(params.nSources));
+    for (double value : { params.D0, params.tol, params.D_min, params.c_t, params.alpha, params.beta, params.gamma }) { mix(&value, sizeof(value)); }
+    mix(&law, sizeof(law));
+    mix(&params.costExponent, sizeof(params.costExponent));
+    mix(&dt, sizeof(dt));
+
+    // then the settings that differ from the original behaviour (Euler steps, fresh Cholesky factors, no pruning)
+    if (settings.integrator != Integrator::Euler)
+    {
+        const uint32_t integrator { static_cast<uint32_t>(settings.integrator) };
+        mix(&integrator, sizeof(integrator));
+        for (double value : { settings.rtol, settings.atol }) { mix(&value, sizeof(value)); }
+    }
+    if (settings.pruning.enabled)
+    {
+        for (double value : { settings.pruning.threshold, settings.pruning.patience }) { mix(&value, sizeof(value)); }
+        mix(&settings.pruning.interval, sizeof(settings.pruning.interval));
+    }
+    if (settings.pressureSolver != PressureSolver::Cholesky)
+    {
+        const uint32_t solver { static_cast<uint32_t>(settings.pressureSolver) };
+        mix(&solver, sizeof(solver));
+    }
+    else if (settings.factorReuse.enabled)
+    {
+        for (double value : { settings.factorReuse.drift, settings.factorReuse.contraction }) { mix(&value, sizeof(value)); }
+        mix(&settings.factorReuse.maxSweeps, sizeof(settings.factorReuse.maxSweeps));
+    }
+
+    char hex[17] {};
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+std::string StateStore::path(uint32_t seed, unsigned int resolution, const Parameters& params, const EvolutionSettings& settings, double dt, const char* extension) const
+{
+    return m_directory + '/' + std::to_string(seed) + '_' + std::to_string(resolution) + '_' + parameterHash(params, settings, dt) + extension;
+}
+
+std::string StateStore::path(const Graph& graph, double dt, const char* extension) const
+{
+    return path(graph.seed(), graph.resolution(), graph.parameters(), graph.evolutionSettings(), dt, extension);
+}
+
+bool StateStore::contains(uint32_t seed, unsigned int resolution, const Parameters& params, const EvolutionSettings& settings, double dt) const
+{
+    return std::filesystem::exists(path(seed, resolution, params, settings, dt, ".state"));
+}
+
+std::vector<uint32_t> StateStore::seeds(unsigned int resolution, const Parameters& params, const EvolutionSettings& settings, double dt) const
+{
+    const std::string key { '_' + std::to_string(resolution) + '_' + parameterHash(params, settings, dt) };
+    std::vector<uint32_t> found;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(m_directory))
+    {
+        const std::string name { entry.path().stem().string() };
+        const std::string extension { entry.path().extension().string() };
+        if ((extension != ".state" && extension != ".partial") || name.size() <= key.size()
+            || name.compare(name.size() - key.size(), key.size(), key) != 0) { continue; }
+
+        uint32_t seed { 0 };
+        const char* last { name.data() + name.size() - key.size() };
+        auto [end, error] { std::from_chars(name.data(), last, seed) };
+        if (error == std::errc{} && end == last) { found.push_back(seed); }
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return found;
+}
+
+bool StateStore::loadConverged(Graph& graph, double dt) const
+{
+    return Checkpoint::load(path(graph, dt, ".state"), graph, dt);
+}
+
+void StateStore::saveConverged(const Graph& graph, double dt) const
+{
+    Checkpoint::save(path(graph, dt, ".state"), graph, dt);
+    std::filesystem::remove(path(graph, dt, ".partial"));
+}
+
+bool StateStore::resume(Graph& graph, double dt) const
+{
+    return Checkpoint::load(path(graph, dt, ".partial"), graph, dt);
+}
+
+void StateStore::checkpoint(const Graph& graph, double dt) const
+{
+    Checkpoint::save(path(graph, dt, ".partial"), graph, dt);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Graph/Graph.hpp"
+
+// fixed-size header of a state file, followed by (all native-endian):
+//   two length-prefixed (uint64) texts : states of the source and initial-D generators (`operator<<` of `std::mt19937`)
+//   float64[edges] x 4                 : Dvec, dDvec, Qvec, model time each edge last dropped to the pruning threshold
+//   float64[nodes] x 2                 : s, p
+//   uint32[aliveEdges]                 : edges still in the linear system
+//   float64[edges]                     : conductances of the last Cholesky factor (only if `factorValid`)
+//   float64[phases], uint64[phases]    : telemetry, seconds and calls per `Phase`
+//   uint64 x 2                         : failed factorizations, failed iterative solves
+//   float64[history] x 2               : conductance and fitness histories
+struct StateHeader
+{
+    char magic[8] {}; // "TKNSTAT3"
+    uint32_t version { 0 };
+    uint32_t seed { 0 };
+    uint32_t resolution { 0 }; // nodes per side
+    uint32_t nSources { 0 };
+    uint32_t law { 0 }; // `EdgeKernel::GrowthLaw`
+    uint32_t integrator { 0 }; // `Integrator` the state was evolved with
+    int32_t groundIdx { 0 };
+    uint32_t converged { 0 }; // bit 0: conductances, bit 1: fitness
+    uint32_t factorValid { 0 }; // the factor reused by `FactorReuseOptions` is rebuilt on load
+    uint32_t reserved { 0 };
+    uint64_t nodes { 0 };
+    uint64_t edges { 0 };
+    uint64_t aliveEdges { 0 };
+    uint64_t steps { 0 }; // calls to `evolveGraph`
+    uint64_t acceptedSteps { 0 };
+    uint64_t rejectedSteps { 0 };
+    uint64_t solves { 0 };
+    uint64_t factorizations { 0 };
+    uint64_t iterations { 0 };
+    uint64_t history { 0 }; // entries of each telemetry history
+    double dt { 0.0 }; // nominal step the run was using
+    double time { 0.0 }; // integrated model time
+    double h { 0.0 }; // current step size (adaptive integrators)
+    double lastH { 0.0 }; // size of the last accepted step
+    double E_prev { 0.0 };
+    double D0 { 0.0 };
+    double tol { 0.0 };
+    double D_min { 0.0 };
+    double c_t { 0.0 };
+    double alpha { 0.0 };
+    double beta { 0.0 };
+    double gamma { 0.0 };
+    double costExponent { 0.0 };
+};
+static_assert(sizeof(StateHeader) == 232, "StateHeader layout is part of the file format");
+
+// Binary snapshots of the full simulation state of a `Graph` (with its telemetry, so resumed runs report whole runs). A state is restored into a graph constructed with
+// the same seed, resolution and parameters (the lattice and the sources are rebuilt by the constructor, the file
+// carries everything that changes afterwards), so the restored graph continues exactly where the saved one stopped.
+// Files are written to a temporary name, synced and renamed, so a preempted writer never leaves a torn state behind.
+class Checkpoint
+{
+private:
+    static StateHeader header(const Graph& graph, double dt);
+    static bool matches(const StateHeader& header, const Graph& graph);
+
+public:
+    static void save(const std::string& filename, const Graph& graph, double dt);
+    // false if there is no such file, it was written by another format version or saved from a graph of another seed,
+    // resolution, parameters or integrator (throws if the file is damaged); `dt`, if given, has to match as well
+    static bool load(const std::string& filename, Graph& graph, double dt = 0.0);
+};
+
+// Directory of states keyed by (seed, resolution, parameters, evolution settings, dt):
+//   <seed>_<resolution>_<hash>.state   : converged networks, loaded instead of evolving them again
+//   <seed>_<resolution>_<hash>.partial : latest checkpoint of an unfinished run (removed once it converges)
+// The hash covers the parameters, dt (Euler equilibria depend on it) and the settings where they differ from the defaults.
+// Different workers write different keys, so no locking is needed.
+class StateStore
+{
+private:
+    std::string m_directory;
+
+    static std::string parameterHash(const Parameters& params, const EvolutionSettings& settings, double dt);
+    std::string path(uint32_t seed, unsigned int resolution, const Parameters& params, const EvolutionSettings& settings, double dt, const char* extension) const;
+    std::string path(const Graph& graph, double dt, const char* extension) const;
+
+public:
+    explicit StateStore(const std::string& directory);
+
+    bool contains(uint32_t seed, unsigned int resolution, const Parameters& params, const EvolutionSettings& settings, double dt) const;
+    // seeds of every converged or checkpointed network of this resolution, parameters, settings and dt (ascending)
+    std::vector<uint32_t> seeds(unsigned int resolution, const Parameters& params, const EvolutionSettings& settings, double dt) const;
+
+    // the network converged with step `dt`; false if there is none
+    bool loadConverged(Graph& graph, double dt) const;
+    void saveConverged(const Graph& graph, double dt) const;
+
+    // continue an unfinished run of the same dt; false if there is none
+    bool resume(Graph& graph, double dt) const;
+    void checkpoint(const Graph& graph, double dt) const;
+
+    const std::string& directory() const { return m_directory; }
+};
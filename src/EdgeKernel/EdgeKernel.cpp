@@ -0,0 +1,286 @@
+#include "EdgeKernel.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    using EdgeKernel::Coefficients;
+    using EdgeKernel::Endpoints;
+    using EdgeKernel::Sums;
+
+    // exponent Num/Den fixed at compile time (Den = 1 or 2), Den = 0 defers to the runtime value
+    template <int Num, int Den>
+    struct Exponent
+    {
+        static constexpr bool runtime { Den == 0 };
+        static constexpr double value { Den == 0 ? 0.0 : static_cast<double>(Num) / Den };
+
+        // x^(Num/Den) for x >= 0 (`std::pow` does not vectorize)
+        static double pow(double x, [[maybe_unused]] double e)
+        {
+            if constexpr (runtime) { return std::pow(x, e); }
+            else if constexpr (Num < 0) { return 1.0 / Exponent<-Num, Den>::pow(x, e); }
+            else
+            {
+                static_assert(Den == 1 || Den == 2, "only integer and half-integer exponents are unrolled");
+                double base { Den == 2 ? std::sqrt(x) : x };
+                double r { 1.0 };
+                for (int n = 0; n < Num; ++n) { r *= base; }
+                return r;
+            }
+        }
+    };
+
+    template <typename Gamma>
+    struct Sigmoid
+    {
+        static double growth(double absQ, double gamma)
+        {
+            double Qgamma { Gamma::pow(absQ, gamma) };
+            return Qgamma / (1.0 + Qgamma);
+        }
+    };
+
+    template <typename Gamma>
+    struct Power
+    {
+        static double growth(double absQ, double gamma) { return Gamma::pow(absQ, gamma); }
+    };
+
+    // D^kappa and its derivatives
+    template <typename Kappa>
+    struct Cost
+    {
+        static double value(double D, double kappa) { return Kappa::pow(D, kappa); }
+
+        static void derivatives(double D, double kappa, double& first, double& second)
+        {
+            if constexpr (Kappa::runtime)
+            {
+                first = kappa * std::pow(D, kappa - 1.0);
+                second = (kappa - 1.0) * first / D;
+            }
+            else
+            {
+                constexpr int num { Kappa::value == 0.0 ? 0 : static_cast<int>(2.0 * Kappa::value) };
+                first = Kappa::value * Exponent<num - 2, 2>::pow(D, kappa);
+                second = Kappa::value * (Kappa::value - 1.0) * Exponent<num - 4, 2>::pow(D, kappa);
+            }
+        }
+    };
+
+    template <typename Law, typename Cost, bool Indexed>
+    Sums eulerPass(const Endpoints& edges, const double* p, double* D, double* Q, double* dD, const Coefficients& c, double dt)
+    {
+        const int* ei { edges.i.data() };
+        const int* ej { edges.j.data() };
+        const int* ek { edges.edge.data() };
+        const int n { static_cast<int>(edges.i.size()) };
+
+        const double alpha { c.alpha }, beta { c.beta }, gamma { c.gamma };
+        const double c_t { c.c_t }, kappa { c.kappa }, D_min { c.D_min };
+
+        double F { 0.0 }, F_old { 0.0 }, dD2 { 0.0 }, D2 { 0.0 };
+
+        #pragma omp simd reduction(+:F, F_old, dD2, D2)
+        for (int a = 0; a < n; ++a)
+        {
+            const int k { Indexed ? ek[a] : a };
+            const double Dk { D[k] };
+
+            // fitness of the previous state (previous flows, conductances before the last update)
+            const double Qold { Q[k] };
+            const double Dold { Dk - dD[k] };
+            F_old += Qold * Qold / Dold + c_t * Cost::value(Dold, kappa);
+
+            const double Qk { Dk * (p[ei[a]] - p[ej[a]]) };
+            F += Qk * Qk / Dk + c_t * Cost::value(Dk, kappa);
+
+            double step { dt * (alpha * Law::growth(std::abs(Qk), gamma) - beta * Dk) };
+            double Dn { Dk + step };
+            // same bookkeeping as the original `updateConductances`
+            const bool clamped { Dn < D_min };
+            step = clamped ? step - (D_min - Dn) : step;
+            Dn = clamped ? D_min : Dn;
+
+            Q[k] = Qk;
+            dD[k] = step;
+            D[k] = Dn;
+            dD2 += step * step;
+            D2 += Dn * Dn;
+        }
+
+        return Sums{ F, F_old, dD2, D2 };
+    }
+
+    template <typename Law, typename Cost>
+    void eulerStepBatch(const Endpoints& edges, int lanes, const double* p, double* D, double* Q, double* dD, const Coefficients& c, double dt, Sums* sums)
+    {
+        const int* ei { edges.i.data() };
+        const int* ej { edges.j.data() };
+        const int n { static_cast<int>(edges.i.size()) };
+        const std::ptrdiff_t K { lanes };
+
+        const double alpha { c.alpha }, beta { c.beta }, gamma { c.gamma };
+        const double c_t { c.c_t }, kappa { c.kappa }, D_min { c.D_min };
+
+        std::vector<double> F(static_cast<std::size_t>(lanes), 0.0), F_old(F), dD2(F), D2(F);
+        double* pF { F.data() };
+        double* pF_old { F_old.data() };
+        double* pdD2 { dD2.data() };
+        double* pD2 { D2.data() };
+
+        for (int a = 0; a < n; ++a)
+        {
+            const double* pi { p + ei[a] * K };
+            const double* pj { p + ej[a] * K };
+            double* Da { D + a * K };
+            double* Qa { Q + a * K };
+            double* dDa { dD + a * K };
+
+            // same arithmetic as `eulerPass`, one lane per graph
+            #pragma omp simd
+            for (int l = 0; l < lanes; ++l)
+            {
+                const double Dk { Da[l] };
+
+                const double Qold { Qa[l] };
+                const double Dold { Dk - dDa[l] };
+                pF_old[l] += Qold * Qold / Dold + c_t * Cost::value(Dold, kappa);
+
+                const double Qk { Dk * (pi[l] - pj[l]) };
+                pF[l] += Qk * Qk / Dk + c_t * Cost::value(Dk, kappa);
+
+                double step { dt * (alpha * Law::growth(std::abs(Qk), gamma) - beta * Dk) };
+                double Dn { Dk + step };
+                const bool clamped { Dn < D_min };
+                step = clamped ? step - (D_min - Dn) : step;
+                Dn = clamped ? D_min : Dn;
+
+                Qa[l] = Qk;
+                dDa[l] = step;
+                Da[l] = Dn;
+                pdD2[l] += step * step;
+                pD2[l] += Dn * Dn;
+            }
+        }
+
+        for (int l = 0; l < lanes; ++l) { sums[l] = Sums{ pF[l], pF_old[l], pdD2[l], pD2[l] }; }
+    }
+
+    template <typename Law, bool Indexed>
+    void ratePass(const Endpoints& edges, const double* p, const double* D, double* Q, double* f, const Coefficients& c)
+    {
+        const int* ei { edges.i.data() };
+        const int* ej { edges.j.data() };
+        const int* ek { edges.edge.data() };
+        const int n { static_cast<int>(edges.i.size()) };
+        const double alpha { c.alpha }, beta { c.beta }, gamma { c.gamma };
+
+        #pragma omp simd
+        for (int a = 0; a < n; ++a)
+        {
+            const int k { Indexed ? ek[a] : a };
+            const double Qk { D[k] * (p[ei[a]] - p[ej[a]]) };
+            Q[k] = Qk;
+            f[k] = alpha * Law::growth(std::abs(Qk), gamma) - beta * D[k];
+        }
+    }
+
+    template <typename Cost>
+    double costSum(const double* D, int n, const Coefficients& c)
+    {
+        const double kappa { c.kappa };
+        double sum { 0.0 };
+        #pragma omp simd reduction(+:sum)
+        for (int k = 0; k < n; ++k) { sum += Cost::value(D[k], kappa); }
+        return sum;
+    }
+
+    template <typename Cost>
+    void costDerivatives(const double* D, int n, const Coefficients& c, double* first, double* second)
+    {
+        for (int k = 0; k < n; ++k) { Cost::derivatives(D[k], c.kappa, first[k], second[k]); }
+    }
+
+    template <typename Law, typename Cost>
+    EdgeKernel::Sums eulerStep(const Endpoints& edges, const double* p, double* D, double* Q, double* dD, const Coefficients& c, double dt)
+    {
+        // direct indexing while every edge takes part
+        if (edges.edge.empty()) { return eulerPass<Law, Cost, false>(edges, p, D, Q, dD, c, dt); }
+        return eulerPass<Law, Cost, true>(edges, p, D, Q, dD, c, dt);
+    }
+
+    template <typename Law>
+    void rate(const Endpoints& edges, const double* p, const double* D, double* Q, double* f, const Coefficients& c)
+    {
+        if (edges.edge.empty()) { ratePass<Law, false>(edges, p, D, Q, f, c); }
+        else { ratePass<Law, true>(edges, p, D, Q, f, c); }
+    }
+
+    // registry key: law, gamma and kappa in halves (-1 for the runtime fallback)
+    using Key = std::tuple<EdgeKernel::GrowthLaw, int, int>;
+
+    template <typename Gamma, typename Kappa>
+    void registerPair(std::map<Key, EdgeKernel::Policy>& registry)
+    {
+        const int g { Gamma::runtime ? -1 : static_cast<int>(2.0 * Gamma::value) };
+        const int k { Kappa::runtime ? -1 : static_cast<int>(2.0 * Kappa::value) };
+        const bool specialized { !Gamma::runtime && !Kappa::runtime };
+
+        registry[Key{ EdgeKernel::GrowthLaw::Sigmoid, g, k }] = EdgeKernel::Policy{
+            &eulerStep<Sigmoid<Gamma>, Cost<Kappa>>, &eulerStepBatch<Sigmoid<Gamma>, Cost<Kappa>>, &rate<Sigmoid<Gamma>>, &costSum<Cost<Kappa>>, &costDerivatives<Cost<Kappa>>, specialized };
+        registry[Key{ EdgeKernel::GrowthLaw::Power, g, k }] = EdgeKernel::Policy{
+            &eulerStep<Power<Gamma>, Cost<Kappa>>, &eulerStepBatch<Power<Gamma>, Cost<Kappa>>, &rate<Power<Gamma>>, &costSum<Cost<Kappa>>, &costDerivatives<Cost<Kappa>>, specialized };
+    }
+
+    template <typename Gamma, typename... Kappas>
+    void registerGamma(std::map<Key, EdgeKernel::Policy>& registry)
+    {
+        (registerPair<Gamma, Kappas>(registry), ...);
+    }
+
+    const std::map<Key, EdgeKernel::Policy>& registry()
+    {
+        // exponents with their own kernels; the runtime entries cover everything else
+        static const std::map<Key, EdgeKernel::Policy> table { []
+        {
+            std::map<Key, EdgeKernel::Policy> r;
+            using K1_2 = Exponent<1, 2>; using K1 = Exponent<1, 1>; using K3_2 = Exponent<3, 2>; using KR = Exponent<0, 0>;
+            registerGamma<Exponent<1, 2>, K1_2, K1, K3_2, KR>(r);
+            registerGamma<Exponent<1, 1>, K1_2, K1, K3_2, KR>(r);
+            registerGamma<Exponent<3, 2>, K1_2, K1, K3_2, KR>(r);
+            registerGamma<Exponent<2, 1>, K1_2, K1, K3_2, KR>(r);
+            registerGamma<Exponent<3, 1>, K1_2, K1, K3_2, KR>(r);
+            registerGamma<Exponent<4, 1>, K1_2, K1, K3_2, KR>(r);
+            registerGamma<Exponent<0, 0>, K1_2, K1, K3_2, KR>(r);
+            return r;
+        }() };
+        return table;
+    }
+
+    // twice the exponent if it is a registered (half-)integer, -1 otherwise
+    int halves(double exponent)
+    {
+        double h { 2.0 * exponent };
+        return (h == std::round(h) && h >= 0.0 && h <= 8.0) ? static_cast<int>(h) : -1;
+    }
+}
+
+const EdgeKernel::Policy& EdgeKernel::policy(GrowthLaw law, double gamma, double kappa, bool specialize)
+{
+    const std::map<Key, Policy>& table { registry() };
+    int g { specialize ? halves(gamma) : -1 };
+    int k { specialize ? halves(kappa) : -1 };
+
+    // fall back one exponent at a time, so e.g. gamma = 3 keeps its kernel with an unusual cost exponent
+    for (const Key& key : { Key{ law, g, k }, Key{ law, g, -1 }, Key{ law, -1, k }, Key{ law, -1, -1 } })
+    {
+        auto it { table.find(key) };
+        if (it != table.end()) { return it->second; }
+    }
+    return table.at(Key{ law, -1, -1 });
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Per-edge math of the adaptation dynamics: one fused pass over the edges per explicit Euler step
+// (flows, fitness, growth law and convergence norms), plus the rate and cost evaluations of the other integrators.
+// Loops are written for `#pragma omp simd` (AVX2/AVX-512 on x86, NEON on arm64) over structure-of-arrays endpoints.
+// The growth law and cost term are compile-time policies; `policy()` picks the specialization for a parameter set.
+namespace EdgeKernel
+{
+    // growth term G of dD/dt = alpha G(|Q|) - beta D
+    enum class GrowthLaw : uint32_t
+    {
+        Sigmoid = 0, // G = |Q|^gamma / (1 + |Q|^gamma) (original law)
+        Power = 1    // G = |Q|^gamma (gamma = 1 is Tero's linear law, gamma = 2 / (1 + exponent) the Hu-Cai steady state)
+    };
+
+    // coefficients of the law and of the cost term c_t D^kappa of the fitness sum Q^2/D + c_t D^kappa
+    struct Coefficients
+    {
+        double alpha;
+        double beta;
+        double gamma;
+        double c_t;
+        double kappa;
+        double D_min;
+    };
+
+    // edges taking part in a pass; `edge[a]` is the index into D/Q/dD of entry a (empty when it is a itself)
+    struct Endpoints
+    {
+        std::vector<int> i {}, j {};
+        std::vector<int> edge {};
+    };
+
+    // reductions gathered alongside an Euler update
+    struct Sums
+    {
+        double F { 0.0 };     // sum Q^2/D + c_t D^kappa with the new flows at the current D
+        double F_old { 0.0 }; // the same with the previous flows at D - dD (the previous state)
+        double dD2 { 0.0 };   // |dD|^2 of this update
+        double D2 { 0.0 };    // |D|^2 after the update
+    };
+
+    // one specialization of the per-edge math (arrays indexed by edge)
+    struct Policy
+    {
+        // Q = D (p_i - p_j), then D += dt dD/dt (clamped to D_min) with dD written out
+        Sums (*eulerStep)(const Endpoints& edges, const double* p, double* D, double* Q, double* dD, const Coefficients& c, double dt);
+        // `eulerStep` of `lanes` graphs on the same (unpruned) edges, arrays interleaved by lane (lane l of entry k at k * lanes + l);
+        // the lanes are the vector dimension and `sums` receives one entry per lane
+        void (*eulerStepBatch)(const Endpoints& edges, int lanes, const double* p, double* D, double* Q, double* dD, const Coefficients& c, double dt, Sums* sums);
+        // Q = D (p_i - p_j) and f = dD/dt at D
+        void (*rate)(const Endpoints& edges, const double* p, const double* D, double* Q, double* f, const Coefficients& c);
+        // sum of D^kappa over n conductances
+        double (*costSum)(const double* D, int n, const Coefficients& c);
+        // kappa D^(kappa - 1) and kappa (kappa - 1) D^(kappa - 2), the derivatives of the cost term over c_t
+        void (*costDerivatives)(const double* D, int n, const Coefficients& c, double* first, double* second);
+        bool specialized; // false when the exponents are evaluated with `std::pow`
+    };
+
+    // registry lookup: integer and half-integer exponents get unrolled kernels, anything else the `std::pow` fallback
+    const Policy& policy(GrowthLaw law, double gamma, double kappa, bool specialize = true);
+}
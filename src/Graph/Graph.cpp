@@ -1,5 +1,10 @@
 #include "Graph.hpp"
 
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
 std::vector<unsigned int> Graph::rectangularBoundaryIndices()
 {
     unsigned int N { m_resolution };
@@ -103,106 +108,343 @@ void Graph::regularLattice(const float width, const float height)
     }
 };
 
+void Graph::fromTopology(const Topology& topology)
+{
+    if (topology.nodeCount() < 2 || topology.sink >= topology.nodeCount())
+    {
+        throw std::invalid_argument("Graph: topology needs at least two nodes and a sink among them");
+    }
+    m_lattice = false;
+    m_sink_idx = topology.sink;
+
+    m_nodes.reserve(topology.nodeCount());
+    for (const glm::fvec2& pos : topology.positions) { m_nodes.emplace_back(Node{ pos }); }
+
+    // same noise as the lattice, drawn in the topology's edge order
+    std::normal_distribution<double> noise(0.0, 2e-1);
+    const int E { static_cast<int>(topology.edgeCount()) };
+    m_edges.reserve(topology.edgeCount());
+    Dvec.resize(E);
+    Qvec.resize(E);
+    Qvec.setZero();
+    dDvec.resize(E);
+    dDvec.setZero();
+    for (const auto& [i, j] : topology.edges)
+    {
+        m_edges.emplace_back(i, j, D0 * (1.0 + noise(m_rng_initD)), 0.0);
+        Dvec(static_cast<int>(m_edges.size() - 1)) = m_edges.back().D;
+    }
+}
+
 void Graph::initLaplacian()
 {
     int N { static_cast<int>(m_nodes.size()) };
     L.resize(N, N);
-    Lr.resize(N-1, N-1);
-    
     p.resize(N);
 
+    m_alive_edges.resize(m_edges.size());
+    std::iota(m_alive_edges.begin(), m_alive_edges.end(), 0u);
+    m_dead_since.assign(m_edges.size(), -1.0);
+    numberReducedSystem();
+
     s.resize(N);
     // merely for visualizing nodes on first frame:
     // assert(m_sink_idx < s.size());
     setSources();
 
-    sr.resize(N-1);
-
-    Eigen::VectorXi nnzPerRow { Eigen::VectorXi::Constant(N, 5) };
-    L.reserve(nnzPerRow);
+    buildLaplacianPattern();
 
+    // pressures are solved with the first step (after the solver has been chosen)
     updateLaplacian();
-    solvePressures();
+    p.setZero();
+    updateNorms();
 }
 
-void Graph::updateLaplacian()
+namespace
 {
-    L.setZero();
+    // position of entry (row, col) in the value array of a compressed column-major matrix
+    int slotOf(const Eigen::SparseMatrix<double>& M, int row, int col)
+    {
+        if (row < 0 || col < 0) { return -1; }
 
-    for (unsigned int k = 0; k < Dvec.size(); ++k)
+        const int* inner { M.innerIndexPtr() };
+        const int* begin { inner + M.outerIndexPtr()[col] };
+        const int* end { inner + M.outerIndexPtr()[col + 1] };
+        const int* it { std::lower_bound(begin, end, row) };
+
+        return (it != end && *it == row) ? static_cast<int>(it - inner) : -1;
+    }
+}
+
+void Graph::numberReducedSystem()
+{
+    // every node touched by a live edge gets a row, except the grounded one
+    std::vector<char> touched(m_nodes.size(), 0);
+    for (unsigned int k : m_alive_edges)
     {
-        const Edge& edge { m_edges[k] };
+        touched[m_edges[k].i] = 1;
+        touched[m_edges[k].j] = 1;
+    }
+    if (!touched[static_cast<std::size_t>(m_ground_idx)]) { m_ground_idx = static_cast<int>(m_sink_idx); }
 
-        unsigned int i { edge.i };
-        unsigned int j { edge.j };
-        double D { Dvec(k) };
+    m_row.assign(m_nodes.size(), -1);
+    m_alive_nodes = 0;
+    int rows { 0 };
+    for (std::size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        if (!touched[i]) { continue; }
+        ++m_alive_nodes;
+        if (static_cast<int>(i) != m_ground_idx) { m_row[i] = rows++; }
+    }
 
-        L.coeffRef(i, j) -= D;
-        L.coeffRef(j, i) -= D;
+    Lr.resize(rows, rows);
+    pr.resize(rows);
+}
 
-        L.coeffRef(i, i) += D;
-        L.coeffRef(j, j) += D;
+void Graph::buildLaplacianPattern()
+{
+    // structural nonzeros of L and Lr (values are overwritten by `updateLaplacian`)
+    std::vector<Eigen::Triplet<double>> trips, tripsR;
+    trips.reserve(4 * m_edges.size());
+    tripsR.reserve(4 * m_edges.size());
+
+    for (unsigned int k : m_alive_edges)
+    {
+        const Edge& edge { m_edges[k] };
+        int i { static_cast<int>(edge.i) };
+        int j { static_cast<int>(edge.j) };
+        trips.emplace_back(i, i, 0.0);
+        trips.emplace_back(j, j, 0.0);
+        trips.emplace_back(i, j, 0.0);
+        trips.emplace_back(j, i, 0.0);
+
+        int ri { m_row[edge.i] };
+        int rj { m_row[edge.j] };
+        if (ri >= 0) { tripsR.emplace_back(ri, ri, 0.0); }
+        if (rj >= 0) { tripsR.emplace_back(rj, rj, 0.0); }
+        if (ri >= 0 && rj >= 0)
+        {
+            tripsR.emplace_back(ri, rj, 0.0);
+            tripsR.emplace_back(rj, ri, 0.0);
+        }
     }
 
+    L.setFromTriplets(trips.begin(), trips.end());
     L.makeCompressed();
+    Lr.setFromTriplets(tripsR.begin(), tripsR.end());
+    Lr.makeCompressed();
+
+    m_endpoints.i.resize(m_alive_edges.size());
+    m_endpoints.j.resize(m_alive_edges.size());
+    for (std::size_t a = 0; a < m_alive_edges.size(); ++a)
+    {
+        m_endpoints.i[a] = static_cast<int>(m_edges[m_alive_edges[a]].i);
+        m_endpoints.j[a] = static_cast<int>(m_edges[m_alive_edges[a]].j);
+    }
+    // direct indexing while nothing is pruned
+    m_endpoints.edge.clear();
+    if (m_alive_edges.size() != m_edges.size()) { m_endpoints.edge.assign(m_alive_edges.begin(), m_alive_edges.end()); }
+
+    // pruned edges keep empty slots
+    m_L_slots.assign(m_edges.size(), EdgeSlots{ -1, -1, -1, -1 });
+    m_Lr_slots.assign(m_edges.size(), EdgeSlots{ -1, -1, -1, -1 });
+    for (unsigned int k : m_alive_edges)
+    {
+        int i { static_cast<int>(m_edges[k].i) };
+        int j { static_cast<int>(m_edges[k].j) };
+        m_L_slots[k] = EdgeSlots{ slotOf(L, i, i), slotOf(L, j, j), slotOf(L, i, j), slotOf(L, j, i) };
+
+        int ri { m_row[m_edges[k].i] };
+        int rj { m_row[m_edges[k].j] };
+        m_Lr_slots[k] = EdgeSlots{ slotOf(Lr, ri, ri), slotOf(Lr, rj, rj), slotOf(Lr, ri, rj), slotOf(Lr, rj, ri) };
+    }
+
+    solverInitialized = false;
+    m_factor_valid = false;
 }
 
-void Graph::solvePressures()
+void Graph::updateLaplacian()
 {
-    int k { 0 }; // pick a zero-pressure node
-    // int k { static_cast<int>(m_sink_idx) };
-    int N { static_cast<int>(m_nodes.size()) };
+    PhaseTimer timer(m_telemetry, Phase::Assembly);
+    // pattern is fixed, so only the value arrays are rewritten
+    double* Lval { L.valuePtr() };
+    double* Lrval { Lr.valuePtr() };
+    std::fill(Lval, Lval + L.nonZeros(), 0.0);
+    std::fill(Lrval, Lrval + Lr.nonZeros(), 0.0);
+
+    for (unsigned int k : m_alive_edges)
+    {
+        double D { Dvec(k) };
+
+        const EdgeSlots& full { m_L_slots[k] };
+        Lval[full.ii] += D;
+        Lval[full.jj] += D;
+        Lval[full.ij] -= D;
+        Lval[full.ji] -= D;
+
+        // the grounded node's row/column is absent from the reduced system
+        const EdgeSlots& red { m_Lr_slots[k] };
+        if (red.ii >= 0) { Lrval[red.ii] += D; }
+        if (red.jj >= 0) { Lrval[red.jj] += D; }
+        if (red.ij >= 0)
+        {
+            Lrval[red.ij] -= D;
+            Lrval[red.ji] -= D;
+        }
+    }
+}
 
-    // index mapping
-    auto map = [&](int i){ return (i < k) ? i : i-1; };
+void Graph::assembleReduced(const Eigen::VectorXd& D, Eigen::SparseMatrix<double>& A) const
+{
+    // `A` must share the pattern of `Lr`
+    double* val { A.valuePtr() };
+    std::fill(val, val + A.nonZeros(), 0.0);
 
-    // fill reduced Laplacian
-    std::vector<Eigen::Triplet<double>> trips;
-    trips.clear();
-    trips.reserve(static_cast<std::size_t>(L.nonZeros()));
-    for (int n = 0; n < N; ++n)
+    for (unsigned int k : m_alive_edges)
     {
-        for (Eigen::SparseMatrix<double>::InnerIterator it(L, n); it; ++it)
+        const EdgeSlots& red { m_Lr_slots[k] };
+        if (red.ii >= 0) { val[red.ii] += D(k); }
+        if (red.jj >= 0) { val[red.jj] += D(k); }
+        if (red.ij >= 0)
         {
-            int i = static_cast<int>(it.row());
-            int j = static_cast<int>(it.col());
-            if (i == k || j == k) continue;
-            trips.emplace_back(map(i), map(j), it.value());
+            val[red.ij] -= D(k);
+            val[red.ji] -= D(k);
         }
     }
-    Lr.setFromTriplets(trips.begin(), trips.end());
-    Lr.makeCompressed();
+}
+
+void Graph::expandPressures(const Eigen::VectorXd& reduced, Eigen::VectorXd& full) const
+{
+    full.resize(static_cast<int>(m_row.size()));
+    for (std::size_t i = 0; i < m_row.size(); ++i)
+    {
+        int r { m_row[i] };
+        full(static_cast<int>(i)) = (r < 0) ? 0.0 : reduced(r);
+    }
+}
+
+void Graph::gatherPressures(const Eigen::VectorXd& full, Eigen::VectorXd& reduced) const
+{
+    reduced.resize(Lr.rows());
+    for (std::size_t i = 0; i < m_row.size(); ++i)
+    {
+        if (m_row[i] >= 0) { reduced(m_row[i]) = full(static_cast<int>(i)); }
+    }
+}
+
+double Graph::pressureTolerance() const
+{
+    // before the first update nothing is known about the change, so the first solve is tight
+    if (m_D_norm2 <= 0.0) { return m_solve_tol_min; }
+    return std::clamp(m_solve_eta * sqrt(m_dD_norm2 / m_D_norm2), m_solve_tol_min, m_solve_tol_max);
+}
 
-    // fill reduced s
-    for (int i = 0; i < N; ++i)
+void Graph::solvePressures()
+{
+    if (m_pressure_solver == PressureSolver::Multigrid)
     {
-        if (i == k) continue;
-        sr(map(i)) = s(i);
+        {
+            PhaseTimer timer(m_telemetry, Phase::Factorization);
+            m_multigrid.setup(static_cast<int>(m_resolution), static_cast<int>(m_resolution), m_endpoints, Dvec.data(), m_ground_idx);
+        }
+        m_multigrid.setTolerance(pressureTolerance(), m_solve_max_iter);
+        ++m_stats.solves;
+        int its { 0 };
+        {
+            // the previous pressures are the initial guess
+            PhaseTimer timer(m_telemetry, Phase::Solve);
+            its = m_multigrid.solve(s.data(), p.data());
+        }
+        m_solve_failed = its < 0;
+        if (its < 0)
+        {
+            std::cerr << "Multigrid did not converge" << std::endl;
+            ++m_telemetry.failedSolves;
+        }
+        m_stats.lastIterations = (its < 0) ? m_solve_max_iter : its;
+        m_stats.iterations += static_cast<std::size_t>(m_stats.lastIterations);
+        m_stats.lastTolerance = m_multigrid.tolerance();
+        gatherPressures(p, pr);
+        return;
     }
 
     if (!solverInitialized) {
+        PhaseTimer timer(m_telemetry, Phase::Factorization);
         solver.analyzePattern(Lr);
         solverInitialized = true;
     }
 
+    // close to steady state the last factor is still a good preconditioner of the current Laplacian
+    if (m_factor_reuse.enabled && m_factor_valid)
+    {
+        double drift { (Dvec - m_D_factored).norm() / m_D_factored.norm() };
+        PhaseTimer timer(m_telemetry, Phase::Solve);
+        if (drift <= m_factor_reuse.drift && refinePressures(pressureTolerance()))
+        {
+            ++m_stats.solves;
+            m_solve_failed = false;
+            expandPressures(pr, p);
+            return;
+        }
+    }
+
     // solve pressures
-    // solver.analyzePattern(Lr);
-    solver.factorize(Lr);
+    {
+        PhaseTimer timer(m_telemetry, Phase::Factorization);
+        solver.factorize(Lr);
+    }
+    ++m_stats.solves;
+    ++m_stats.factorizations;
+    m_stats.lastIterations = 0;
 
-    if (solver.info() == Eigen::Success)
+    m_solve_failed = solver.info() != Eigen::Success;
+    if (!m_solve_failed)
     {
-        Eigen::VectorXd pr = solver.solve(sr);
+        PhaseTimer timer(m_telemetry, Phase::Solve);
+        pr = solver.solve(sr);
         // reconstruct full p
-        p.setZero();
-        for (int i = 0; i < N; ++i)
-            if (i != k)
-                p(i) = pr(map(i));
+        expandPressures(pr, p);
+        m_D_factored = Dvec;
+        m_factor_valid = true;
     }
     else
     {
         // Handle the error (e.g., matrix is singular)
         std::cerr << "Decomposition Failed" << std::endl;
         // std::cerr << "Decomposition Failed: " << solver.lastErrorMessage() << std::endl;
+        m_factor_valid = false;
+        ++m_telemetry.failedFactorizations;
+    }
+}
+
+bool Graph::refinePressures(double tol)
+{
+    // iterative refinement of the last pressures with the stale factor: pr += F^-1 (sr - Lr pr), until the error
+    // estimate r^T F^-1 r drops below tol^2 times the energy sr^T pr; false if a sweep contracts too little
+    m_refine_r = sr;
+    m_refine_r.noalias() -= Lr * pr;
+    m_refine_z = solver.solve(m_refine_r);
+    double rz { m_refine_r.dot(m_refine_z) };
+    const double contraction2 { m_factor_reuse.contraction * m_factor_reuse.contraction };
+
+    for (unsigned int sweep = 0; ; ++sweep)
+    {
+        if (rz <= tol * tol * std::abs(sr.dot(pr)))
+        {
+            m_stats.lastIterations = static_cast<int>(sweep);
+            m_stats.iterations += sweep;
+            m_stats.lastTolerance = tol;
+            return true;
+        }
+        if (sweep == m_factor_reuse.maxSweeps) { return false; }
+
+        pr += m_refine_z;
+        m_refine_r = sr;
+        m_refine_r.noalias() -= Lr * pr;
+        m_refine_z = solver.solve(m_refine_r);
+        double rzNew { m_refine_r.dot(m_refine_z) };
+        if (rzNew > contraction2 * rz) { return false; }
+        rz = rzNew;
     }
 }
 
@@ -237,21 +479,35 @@ void Graph::setSources()
     s(m_sink_idx) = -s.sum();
     s.normalize();
     s *= I0;
+
+    fillReducedSources();
+}
+
+void Graph::fillReducedSources()
+{
+    // reduced sources only change with `s` or the numbering, so they are filled here rather than every solve
+    sr.resize(pr.size());
+    for (std::size_t i = 0; i < m_row.size(); ++i)
+    {
+        if (m_row[i] >= 0) { sr(m_row[i]) = s(static_cast<int>(i)); }
+    }
 }
 
 void Graph::computeFlows(bool checkConvergence)
 {
+    PhaseTimer timer(m_telemetry, Phase::EdgeKernel);
     // std::cout << "###############################" << '\n';
     // for dissipation energy metric
     double E_old { dissipation(Dvec-dDvec) };
     // double E_old { E };
     // E = 0.0;
 
-    for (unsigned int k = 0; k < Dvec.size(); ++k)
+    // endpoints from the packed arrays (aligned with `m_alive_edges`) rather than the full `Edge` records
+    for (std::size_t a = 0; a < m_alive_edges.size(); ++a)
     {
-        const Edge& edge { m_edges[k] };
+        const unsigned int k { m_alive_edges[a] };
         
-        Qvec(k) = Dvec(k) * (p(edge.i) - p(edge.j));
+        Qvec(k) = Dvec(k) * (p(m_endpoints.i[a]) - p(m_endpoints.j[a]));
         // std::cout << "D_k : " << '\t' << Dvec(k) << '\t' << "|Q_k| : " << '\t' << abs(Qvec(k)) << '\t' << "E_k : " << '\t' << Qvec(k) * Qvec(k) / Dvec(k) << '\n';
         // E += Qvec(k) * Qvec(k) / Dvec(k); // might need its own wrapper but fine for now
     }
@@ -263,15 +519,12 @@ void Graph::computeFlows(bool checkConvergence)
 
 void Graph::updateConductances(const double dt)
 {
-    double alpha { 100.0 };
-    double beta { 10.0 };
-    double gamma { 3.0 };
-
-    for (unsigned int k = 0; k < Dvec.size(); ++k)
+    // rates from the pressures of the last solve (recomputes the same `Qvec`)
+    PhaseTimer timer(m_telemetry, Phase::EdgeKernel);
+    m_policy.rate(m_endpoints, p.data(), Dvec.data(), Qvec.data(), dDvec.data(), coefficients());
+    for (unsigned int k : m_alive_edges)
     {
-        double Qgamma { pow(abs(Qvec(k)), gamma) };
-        dDvec(k) = dt * ( alpha * Qgamma / (1.0 + Qgamma) - beta * Dvec(k) );
-        // dDvec(k) = dt * ( alpha * pow(abs(Qvec(k)), gamma) - beta * Dvec(k) );
+        dDvec(k) *= dt;
         Dvec(k) += dDvec(k);
         if (Dvec(k) < D_min)
         {
@@ -279,12 +532,348 @@ void Graph::updateConductances(const double dt)
             Dvec(k) = D_min;
         }
     }
+
+    updateNorms();
+    m_probe_ready = false;
+    m_fsal = false;
+}
+
+void Graph::eulerStep(const double dt)
+{
+    updateLaplacian();
+    solvePressures();
+
+    // flows, fitness, growth law and norms in one pass (`computeFlows` + `updateConductances` + `conductanceConverged`)
+    const EdgeKernel::Coefficients coeffs { coefficients() };
+    EdgeKernel::Sums sums {};
+    {
+        PhaseTimer timer(m_telemetry, Phase::EdgeKernel);
+        sums = m_policy.eulerStep(m_endpoints, p.data(), Dvec.data(), Qvec.data(), dDvec.data(), coeffs, dt);
+    }
+
+    // pruned edges sit at D_min with Q = 0 and dD = 0
+    const double nPruned { static_cast<double>(m_edges.size() - m_alive_edges.size()) };
+    const double prunedCost { nPruned * c_t * m_policy.costSum(&D_min, 1, coeffs) };
+    sums.F += prunedCost;
+    sums.F_old += prunedCost;
+    sums.D2 += nPruned * D_min * D_min;
+
+    m_fitness_change = (sums.F - sums.F_old) / sums.F_old;
+    if (m_fitness_change < m_tol) { fitnessConverged = true; }
+    m_dD_norm2 = sums.dD2;
+    m_D_norm2 = sums.D2;
+
+    m_probe_ready = false;
+    m_fsal = false;
+}
+
+void Graph::setState(const Eigen::VectorXd& D, const Eigen::VectorXd& Q, const Eigen::VectorXd& dD)
+{
+    // conductances computed elsewhere, with the flows and change of the step that produced them
+    Dvec = D;
+    Qvec = Q;
+    dDvec = dD;
+    updateNorms();
+
+    m_probe_ready = false;
+    m_fsal = false;
+    m_E_prev = -1.0;
+}
+
+void Graph::updateNorms()
+{
+    m_dD_norm2 = dDvec.squaredNorm();
+    m_D_norm2 = Dvec.squaredNorm();
+}
+
+void Graph::setPressureSolver(PressureSolver type)
+{
+    // the multigrid hierarchy coarsens the lattice geometrically
+    if (type == PressureSolver::Multigrid && !m_lattice)
+    {
+        throw std::invalid_argument("Graph: the multigrid pressure solver needs a regular lattice");
+    }
+    m_pressure_solver = type;
+}
+
+void Graph::setIntegrator(Integrator type, double rtol, double atol)
+{
+    m_integrator = type;
+    m_rtol = rtol;
+    m_atol = atol;
+    m_stats.h = 0.0; // adaptive integrators restart from the nominal step
+    m_fsal = false;
+    m_E_prev = -1.0;
+}
+
+void Graph::evaluateRate(Eigen::VectorXd& D, Eigen::VectorXd& f)
+{
+    // f = dD/dt at the conductances D (clamped to D_min), leaves `p` and `Qvec` consistent with D
+    D = D.cwiseMax(D_min);
+    Dvec.swap(D);
+    updateLaplacian();
+    solvePressures();
+    f.setZero(); // pruned edges are frozen
+    PhaseTimer timer(m_telemetry, Phase::EdgeKernel);
+    m_policy.rate(m_endpoints, p.data(), Dvec.data(), Qvec.data(), f.data(), coefficients());
+    Dvec.swap(D);
+}
+
+double Graph::errorNorm(const Eigen::VectorXd& err, const Eigen::VectorXd& D_old, const Eigen::VectorXd& D_new) const
+{
+    // RMS of the local error relative to the mixed tolerance
+    double sum { 0.0 };
+    for (unsigned int k : m_alive_edges)
+    {
+        double scale { m_atol + m_rtol * std::max(abs(D_old(k)), abs(D_new(k))) };
+        sum += (err(k) / scale) * (err(k) / scale);
+    }
+    return sqrt(sum / static_cast<double>(m_alive_edges.size()));
+}
+
+void Graph::checkFitness(double dt)
+{
+    // `Qvec` holds the flows at `Dvec`, the relative change of dissipation over the last accepted step is scaled to
+    // one nominal step (`m_stats.h` is already the controller's proposal for the next one)
+    double E { dissipation(Dvec) };
+    if (m_E_prev > 0.0 && m_stats.lastH > 0.0)
+    {
+        m_fitness_change = (E - m_E_prev) / m_E_prev * (dt / m_stats.lastH);
+        if (m_fitness_change < m_tol) { fitnessConverged = true; }
+    }
+    m_E_prev = E;
+}
+
+void Graph::acceptStep(double h, double dt)
+{
+    dDvec = (m_D_new - Dvec) * (dt / h);
+    Dvec.swap(m_D_new);
+    updateNorms();
+    m_stats.time += h;
+    m_stats.lastH = h;
+    ++m_stats.steps;
+    m_probe_ready = false;
+}
+
+namespace
+{
+    // step size controller of an embedded pair whose lower order is `q`
+    double nextStepFactor(double err, int q)
+    {
+        const double safety { 0.9 }, facMin { 0.2 }, facMax { 5.0 };
+        if (err == 0.0) { return facMax; }
+        return std::clamp(safety * pow(err, -1.0 / (q + 1)), facMin, facMax);
+    }
+}
+
+void Graph::stepBogackiShampine(const double dt)
+{
+    const Eigen::Index nEdges { Dvec.size() };
+    for (Eigen::VectorXd& k : m_k) { k.resize(nEdges); }
+    if (m_stats.h == 0.0) { m_stats.h = dt; }
+
+    if (!m_fsal)
+    {
+        m_D_stage = Dvec;
+        evaluateRate(m_D_stage, m_k[0]);
+        m_fsal = true;
+    }
+    checkFitness(dt);
+
+    while (true)
+    {
+        const double h { m_stats.h };
+
+        m_D_stage = Dvec + 0.5 * h * m_k[0];
+        evaluateRate(m_D_stage, m_k[1]);
+        m_D_stage = Dvec + 0.75 * h * m_k[1];
+        evaluateRate(m_D_stage, m_k[2]);
+
+        m_D_new = Dvec + h * (2.0 / 9.0 * m_k[0] + 1.0 / 3.0 * m_k[1] + 4.0 / 9.0 * m_k[2]);
+        evaluateRate(m_D_new, m_k[3]); // clamps `m_D_new`, rate doubles as the next step's first stage
+
+        // spectral radius of the Jacobian seen by the last two stages (Hairer & Wanner, IV.2);
+        // near steady state the error estimate vanishes, so the step is kept inside the stability region explicitly
+        double dStage { (m_D_new - m_D_stage).norm() };
+        double rho { dStage > 0.0 ? (m_k[3] - m_k[2]).norm() / dStage : 0.0 };
+
+        // difference to the embedded second order solution
+        m_D_stage = Dvec + h * (7.0 / 24.0 * m_k[0] + 0.25 * m_k[1] + 1.0 / 3.0 * m_k[2] + 0.125 * m_k[3]);
+        double err { errorNorm(m_D_new - m_D_stage, Dvec, m_D_new) };
+
+        // stability interval of the scheme on the negative real axis is ~2.5, stay well inside it
+        m_stats.h = h * nextStepFactor(err, 2);
+        if (rho > 0.0) { m_stats.h = std::min(m_stats.h, 2.0 / rho); }
+        if (err <= 1.0)
+        {
+            acceptStep(h, dt);
+            m_k[0].swap(m_k[3]);
+            return;
+        }
+        ++m_stats.rejected;
+    }
+}
+
+void Graph::stepExponential(const double dt)
+{
+    // ETD2 (Cox & Matthews) with the decay -beta D integrated exactly and the growth term N(D) = dD/dt + beta D
+    // interpolated linearly over the step; the first stage (exponential Euler) is the embedded first-order solution
+    const Eigen::Index nEdges { Dvec.size() };
+    for (Eigen::VectorXd& k : m_k) { k.resize(nEdges); }
+    if (m_stats.h == 0.0) { m_stats.h = dt; }
+
+    Eigen::VectorXd& N0 { m_k[0] };
+    Eigen::VectorXd& N1 { m_k[1] };
+    m_D_stage = Dvec;
+    evaluateRate(m_D_stage, N0);
+    checkFitness(dt);
+    for (unsigned int k : m_alive_edges) { N0(k) += beta * Dvec(k); }
+
+    while (true)
+    {
+        const double h { m_stats.h };
+        const double z { -beta * h };
+        const double e { exp(z) };
+        // phi_1(z) = (e^z - 1) / z, phi_2(z) = (e^z - 1 - z) / z^2 (series near 0)
+        const double phi1 { abs(z) < 1e-5 ? 1.0 + z / 2.0 : expm1(z) / z };
+        const double phi2 { abs(z) < 1e-5 ? 0.5 + z / 6.0 : (expm1(z) - z) / (z * z) };
+
+        m_D_stage = Dvec; // pruned edges are frozen
+        for (unsigned int k : m_alive_edges) { m_D_stage(k) = e * Dvec(k) + h * phi1 * N0(k); }
+        evaluateRate(m_D_stage, N1); // clamps the stage
+        for (unsigned int k : m_alive_edges) { N1(k) += beta * m_D_stage(k); }
+
+        m_k[2] = h * phi2 * (N1 - N0); // second-order correction, doubles as the error estimate
+        m_D_new = (m_D_stage + m_k[2]).cwiseMax(D_min);
+        double err { errorNorm(m_k[2], Dvec, m_D_new) };
+
+        m_stats.h = h * nextStepFactor(err, 1);
+        if (err <= 1.0)
+        {
+            acceptStep(h, dt);
+            return;
+        }
+        ++m_stats.rejected;
+    }
+}
+
+void Graph::trackDeadEdges()
+{
+    for (unsigned int k : m_alive_edges)
+    {
+        if (Dvec(k) > m_prune.threshold) { m_dead_since[k] = -1.0; }
+        else if (m_dead_since[k] < 0.0) { m_dead_since[k] = m_stats.time; }
+    }
+
+    if (m_steps % std::max(m_prune.interval, 1u) == 0) { pruneEdges(); }
+}
+
+void Graph::pruneEdges()
+{
+    // 0: pruned before, 1: keep, 2: candidate
+    std::vector<char> state(m_edges.size(), 0);
+    bool anyCandidate { false };
+    for (unsigned int k : m_alive_edges)
+    {
+        state[k] = (m_dead_since[k] >= 0.0 && m_stats.time - m_dead_since[k] >= m_prune.patience) ? 2 : 1;
+        anyCandidate |= (state[k] == 2);
+    }
+    if (!anyCandidate) { return; }
+
+    // live edges adjacent to each node
+    const std::size_t N { m_nodes.size() };
+    std::vector<unsigned int> offset(N + 1, 0), incident(2 * m_alive_edges.size());
+    for (unsigned int k : m_alive_edges) { ++offset[m_edges[k].i + 1]; ++offset[m_edges[k].j + 1]; }
+    for (std::size_t i = 0; i < N; ++i) { offset[i + 1] += offset[i]; }
+    {
+        std::vector<unsigned int> fill(offset.begin(), offset.end() - 1);
+        for (unsigned int k : m_alive_edges) { incident[fill[m_edges[k].i]++] = k; incident[fill[m_edges[k].j]++] = k; }
+    }
+    auto other = [&](unsigned int k, unsigned int i) { return m_edges[k].i == i ? m_edges[k].j : m_edges[k].i; };
+
+    // 0-1 BFS from the sink (kept edges cost 0, candidates 1); candidates on the cheapest path
+    // to any source are kept, so pruning never cuts a source off from the sink
+    const unsigned int none { std::numeric_limits<unsigned int>::max() };
+    std::vector<unsigned int> cost(N, none), via(N, none);
+    std::deque<unsigned int> queue { m_sink_idx };
+    cost[m_sink_idx] = 0;
+    while (!queue.empty())
+    {
+        unsigned int i { queue.front() };
+        queue.pop_front();
+        for (unsigned int e = offset[i]; e < offset[i + 1]; ++e)
+        {
+            unsigned int k { incident[e] };
+            unsigned int j { other(k, i) };
+            unsigned int w { state[k] == 2 ? 1u : 0u };
+            if (cost[i] + w < cost[j])
+            {
+                cost[j] = cost[i] + w;
+                via[j] = k;
+                if (w == 0) { queue.push_front(j); } else { queue.push_back(j); }
+            }
+        }
+    }
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        if (i == m_sink_idx || s(i) == 0.0) { continue; }
+        for (unsigned int j = i; via[j] != none && cost[j] > 0; j = other(via[j], j))
+        {
+            if (state[via[j]] == 2) { state[via[j]] = 1; }
+        }
+    }
+
+    // kept edges no longer connected to the sink carry no flow (and would leave Lr singular), so they go as well
+    std::vector<char> reached(N, 0);
+    queue.assign(1, m_sink_idx);
+    reached[m_sink_idx] = 1;
+    while (!queue.empty())
+    {
+        unsigned int i { queue.front() };
+        queue.pop_front();
+        for (unsigned int e = offset[i]; e < offset[i + 1]; ++e)
+        {
+            unsigned int k { incident[e] };
+            unsigned int j { other(k, i) };
+            if (state[k] == 1 && !reached[j]) { reached[j] = 1; queue.push_back(j); }
+        }
+    }
+
+    std::vector<unsigned int> alive;
+    alive.reserve(m_alive_edges.size());
+    for (unsigned int k : m_alive_edges)
+    {
+        if (state[k] == 1 && reached[m_edges[k].i]) { alive.push_back(k); }
+        else
+        {
+            Dvec(k) = D_min;
+            Qvec(k) = 0.0;
+            dDvec(k) = 0.0;
+        }
+    }
+    if (alive.size() == m_alive_edges.size()) { return; }
+
+    m_alive_edges.swap(alive);
+    updateNorms();
+    numberReducedSystem();
+    fillReducedSources();
+    buildLaplacianPattern();
+
+    m_probe_ready = false;
+    m_probe_ws.fallbackInitialized = false;
+    m_fsal = false;
+    m_E_prev = -1.0; // pinning pruned edges to the floor shifts the dissipation slightly
 }
 
 double Graph::dissipation(const Eigen::VectorXd& D)
 {
     // assumes conductances have already been updated to next step
-    return (Qvec.cwiseProduct(Qvec).cwiseQuotient(D) + c_t * D.cwisePow(0.5)).sum();
+    return dissipation(Qvec, D);
+}
+
+double Graph::dissipation(const Eigen::VectorXd& Q, const Eigen::VectorXd& D) const
+{
+    return Q.cwiseProduct(Q).cwiseQuotient(D).sum() + c_t * m_policy.costSum(D.data(), static_cast<int>(D.size()), coefficients());
 }
 
 double Graph::efficiency(const Eigen::VectorXd& D)
@@ -299,11 +888,116 @@ double Graph::transportCost()
 
 bool Graph::conductanceConverged() const
 {
-    return dDvec.norm() / Dvec.norm() < m_tol;
+    return sqrt(m_dD_norm2 / m_D_norm2) < m_tol;
+}
+
+void Graph::prepareProbe()
+{
+    // dead edges are dropped first, so the probe factor only covers the live network
+    if (m_prune.enabled) { pruneEdges(); }
+
+    // factor the converged reduced Laplacian once; perturbed systems are solved against it with CG
+    // (`solver`, `p` and `Qvec` are left untouched, so nothing has to be restored afterwards)
+    m_probe_ws.Lr = Lr;
+    assembleReduced(Dvec, m_probe_ws.Lr);
+    m_probe_factor.compute(m_probe_ws.Lr);
+    if (m_probe_factor.info() != Eigen::Success)
+    {
+        std::cerr << "Decomposition Failed" << std::endl;
+    }
+
+    m_probe_pr = m_probe_factor.solve(sr);
+    m_probe_ready = true;
+    m_probe_Fstar = probeFitness(Dvec, m_probe_ws);
+
+    // dF/dD_e = -g_e^2 + c_t kappa D_e^(kappa - 1), with g_e the pressure drop across edge e
+    m_probe_g = m_probe_ws.Q.cwiseQuotient(Dvec);
+    m_probe_grad.resize(Dvec.size());
+    m_probe_cost2.resize(Dvec.size());
+    m_policy.costDerivatives(Dvec.data(), static_cast<int>(Dvec.size()), coefficients(), m_probe_grad.data(), m_probe_cost2.data());
+    m_probe_grad = c_t * m_probe_grad - m_probe_g.cwiseAbs2();
+    m_probe_cost2 *= c_t;
+}
+
+void Graph::initProbeWorkspace(ProbeWorkspace& ws) const
+{
+    ws.Lr = Lr; // only the pattern matters, values are overwritten per probe
+    ws.fallbackInitialized = false;
+}
+
+int Graph::preconditionedCG(const Eigen::SparseMatrix<double>& A, const Eigen::VectorXd& b, Eigen::VectorXd& x, ProbeWorkspace& ws) const
+{
+    // returns the iteration count, or -1 if the residual did not reach round-off level
+    const double bnorm { b.norm() };
+    const double tol { m_probe_tol * bnorm };
+
+    ws.r = b;
+    ws.r.noalias() -= A * x;
+    double rnorm { ws.r.norm() };
+    if (rnorm <= tol) { return 0; }
+
+    ws.z = m_probe_factor.solve(ws.r);
+    ws.d = ws.z;
+    double rz { ws.r.dot(ws.z) };
+    double best { rnorm };
+    int stall { 0 };
+
+    for (int it = 1; it <= m_probe_max_iter; ++it)
+    {
+        ws.Ld.noalias() = A * ws.d;
+        double alpha { rz / ws.d.dot(ws.Ld) };
+        x += alpha * ws.d;
+        ws.r -= alpha * ws.Ld;
+
+        rnorm = ws.r.norm();
+        if (rnorm <= tol) { return it; }
+
+        // the residual stagnates once it hits round-off of the triangular solves
+        if (rnorm < best) { best = rnorm; stall = 0; }
+        else if (++stall >= 2) { return (best <= 1e-10 * bnorm) ? it : -1; }
+
+        ws.z = m_probe_factor.solve(ws.r);
+        double rzNew { ws.r.dot(ws.z) };
+        ws.d = ws.z + (rzNew / rz) * ws.d;
+        rz = rzNew;
+    }
+
+    return -1;
+}
+
+double Graph::probeFitness(const Eigen::VectorXd& D, ProbeWorkspace& ws) const
+{
+    // dissipation of the network with conductances `D`, or -1 if the perturbed system could not be solved
+    assembleReduced(D, ws.Lr);
+
+    ws.pr = m_probe_pr;
+    if (preconditionedCG(ws.Lr, sr, ws.pr, ws) < 0)
+    {
+        // large perturbations (e.g. pruning) can defeat the preconditioner
+        if (!ws.fallbackInitialized)
+        {
+            ws.fallback.analyzePattern(ws.Lr);
+            ws.fallbackInitialized = true;
+        }
+        ws.fallback.factorize(ws.Lr);
+        if (ws.fallback.info() != Eigen::Success) { return -1; }
+        ws.pr = ws.fallback.solve(sr);
+    }
+
+    expandPressures(ws.pr, ws.p);
+    ws.Q.setZero(D.size());
+    for (unsigned int k : m_alive_edges)
+    {
+        const Edge& edge { m_edges[k] };
+        ws.Q(k) = D(k) * (ws.p(edge.i) - ws.p(edge.j));
+    }
+
+    return dissipation(ws.Q, D);
 }
 
-Eigen::VectorXd Graph::createScalePerturbationVec(std::mt19937& rng, double eps) //, std::vector<unsigned int> aliveIdxs)
+Eigen::VectorXd Graph::randomDirection(std::mt19937& rng) const
 {
+    // isotropic unit vector in edge space
     std::normal_distribution<double> noise(0.0, 1.0);
     unsigned int N { static_cast<unsigned int>(Dvec.size()) };
     Eigen::VectorXd v(N);
@@ -313,14 +1007,96 @@ Eigen::VectorXd Graph::createScalePerturbationVec(std::mt19937& rng, double eps)
         v(i) = noise(rng);
     }
 
-    return (eps * v.normalized()).array().exp();
+    return v.normalized();
+}
+
+Eigen::VectorXd Graph::createScalePerturbationVec(std::mt19937& rng, double eps) const //, std::vector<unsigned int> aliveIdxs)
+{
+    return (eps * randomDirection(rng)).array().exp();
+}
+
+void Graph::hessianVectorProduct(const Eigen::VectorXd& v, Eigen::VectorXd& Hv, ProbeWorkspace& ws) const
+{
+    // Differentiating L(D) p = s along v gives L dp = -B^T (v o g), hence
+    //     H v = 2 g o (B L^-1 B^T (g o v)) + c_t kappa (kappa - 1) D^(kappa - 2) o v
+    // which costs one triangular solve pair with the converged factor.
+    if (!m_probe_ready) { throw std::logic_error("prepareProbe() must be called before probing"); }
+
+    ws.r.setZero(Lr.rows());
+    for (unsigned int k : m_alive_edges)
+    {
+        const Edge& edge { m_edges[k] };
+        double w { m_probe_g(k) * v(k) };
+        int ri { m_row[edge.i] };
+        int rj { m_row[edge.j] };
+        if (ri >= 0) { ws.r(ri) += w; }
+        if (rj >= 0) { ws.r(rj) -= w; }
+    }
+
+    ws.pr = m_probe_factor.solve(ws.r);
+    expandPressures(ws.pr, ws.p);
+
+    Hv.resize(Dvec.size());
+    for (unsigned int k = 0; k < Dvec.size(); ++k)
+    {
+        const Edge& edge { m_edges[k] };
+        Hv(k) = 2.0 * m_probe_g(k) * (ws.p(edge.i) - ws.p(edge.j)) + m_probe_cost2(k) * v(k);
+    }
+}
+
+void Graph::scaledHessianProduct(const Eigen::VectorXd& x, Eigen::VectorXd& y, ProbeWorkspace& ws) const
+{
+    // Hessian in log-conductance coordinates, normalized by the converged fitness:
+    // y = (D o H (D o x) + grad F o D o x) / F*
+    ws.D = Dvec.cwiseProduct(x);
+    hessianVectorProduct(ws.D, y, ws);
+    y = (Dvec.cwiseProduct(y) + m_probe_grad.cwiseProduct(ws.D)) / m_probe_Fstar;
+}
+
+double Graph::probeHessianExact(std::mt19937& rng, ProbeWorkspace& ws) const
+{
+    // exact limit of `probeHessianViaScale` as eps -> 0 (same random direction for the same rng state):
+    // d^2/de^2 F(D o exp(e u)) = (D o u)^T H (D o u) + grad F . (D o u o u)
+    Eigen::VectorXd u { randomDirection(rng) };
+    ws.D = Dvec.cwiseProduct(u);
+    hessianVectorProduct(ws.D, ws.Q, ws);
+
+    return (ws.D.dot(ws.Q) + m_probe_grad.dot(ws.D.cwiseProduct(u))) / m_probe_Fstar;
+}
+
+double Graph::probeHessianViaScale(std::mt19937& rng, double eps, ProbeWorkspace& ws) const
+{
+    if (!m_probe_ready) { throw std::logic_error("prepareProbe() must be called before probing"); }
+
+    Eigen::VectorXd delta { createScalePerturbationVec(rng, eps) };
+
+    ws.D = Dvec.cwiseProduct(delta);
+    double Fplus { probeFitness(ws.D, ws) };
+
+    ws.D = Dvec.cwiseQuotient(delta);
+    double Fminus { probeFitness(ws.D, ws) };
+
+    if (Fplus < 0.0 || Fminus < 0.0) { return -1; }
+    return (Fplus - 2.0 * m_probe_Fstar + Fminus) / (eps * eps) / m_probe_Fstar;
 }
 
 double Graph::probeHessianViaScale(std::mt19937& rng, double eps)//, std::vector<unsigned int> aliveIdxs)
 {
+    if (m_probe_solver_type == ProbeSolver::Adjoint)
+    {
+        if (!m_probe_ready) { prepareProbe(); }
+        return probeHessianExact(rng, m_probe_ws);
+    }
+    if (m_probe_solver_type == ProbeSolver::Preconditioned)
+    {
+        if (!m_probe_ready) { prepareProbe(); }
+        return probeHessianViaScale(rng, eps, m_probe_ws);
+    }
+
     // store converged fitness
     solveStep(false);
     double Fstar { dissipation(Dvec) };
+    bool failed { m_solve_failed };
     
     Eigen::VectorXd delta { createScalePerturbationVec(rng, eps) };
 
@@ -331,10 +1107,12 @@ double Graph::probeHessianViaScale(std::mt19937& rng, double eps)//, std::vector
     Dvec = Dstar.cwiseProduct(delta);
     solveStep(false); // recompute flows to get fitness
     double Fplus { dissipation(Dvec) };
+    failed = failed || m_solve_failed;
     
     Dvec = Dstar.cwiseQuotient(delta);
     solveStep(false);
     double Fminus { dissipation(Dvec) };
+    failed = failed || m_solve_failed;
 
     // revert system to steady state
     // (don't need to recompute flows unless the simulation will continue to evolve beyond Hessian probing)
@@ -344,7 +1122,8 @@ double Graph::probeHessianViaScale(std::mt19937& rng, double eps)//, std::vector
     Dvec = Dstar;
 
     // normalize by Fstar to compile Rayleigh coefficients across multiple graph instances
-    if (solver.info() != Eigen::Success)
+    // (`m_solve_failed` covers the multigrid solver, which never factors `solver`)
+    if (failed || m_solve_failed)
     {
         return -1;
     }
@@ -354,7 +1133,7 @@ double Graph::probeHessianViaScale(std::mt19937& rng, double eps)//, std::vector
     }
 }
 
-Eigen::VectorXd Graph::createAddPerturbationVec(std::mt19937& rng, double eps)
+Eigen::VectorXd Graph::createAddPerturbationVec(std::mt19937& rng, double eps) const
 {
     unsigned int N { static_cast<unsigned int>(Dvec.size()) };
     Eigen::VectorXd v(N);
@@ -368,11 +1147,35 @@ Eigen::VectorXd Graph::createAddPerturbationVec(std::mt19937& rng, double eps)
     return eps * v / sqrt(N);
 }
 
+double Graph::probeHessianViaAdd(std::mt19937& rng, double eps, ProbeWorkspace& ws) const
+{
+    if (!m_probe_ready) { throw std::logic_error("prepareProbe() must be called before probing"); }
+
+    Eigen::VectorXd delta { createAddPerturbationVec(rng, eps) };
+    delta *= Dvec.norm() / sqrt(static_cast<double>(Dvec.size()));
+
+    ws.D = (Dvec + delta).cwiseMax(D_min);
+    double Fplus { probeFitness(ws.D, ws) };
+
+    ws.D = (Dvec - delta).cwiseMax(D_min);
+    double Fminus { probeFitness(ws.D, ws) };
+
+    if (Fplus < 0.0 || Fminus < 0.0) { return -1; }
+    return (Fplus - 2.0 * m_probe_Fstar + Fminus) / (eps * eps) / m_probe_Fstar;
+}
+
 double Graph::probeHessianViaAdd(std::mt19937& rng, double eps)//, std::vector<unsigned int> aliveIdxs)
 {
+    if (m_probe_solver_type != ProbeSolver::Refactor)
+    {
+        if (!m_probe_ready) { prepareProbe(); }
+        return probeHessianViaAdd(rng, eps, m_probe_ws);
+    }
+
     // store converged fitness
     solveStep(false);
     double Fstar { dissipation(Dvec) };
+    bool failed { m_solve_failed };
     
     Eigen::VectorXd delta { createAddPerturbationVec(rng, eps) };
 
@@ -391,11 +1194,13 @@ double Graph::probeHessianViaAdd(std::mt19937& rng, double eps)//, std::vector<u
     // recompute flows to get fitness
     solveStep(false);
     double Fplus { dissipation(Dvec) };
+    failed = failed || m_solve_failed;
     
     // - delta
     Dvec = (Dstar - delta).cwiseMax(D_min);
     solveStep(false);
     double Fminus { dissipation(Dvec) };
+    failed = failed || m_solve_failed;
 
     // revert system to steady state
     Dvec = Dstar - dDvec;
@@ -404,7 +1209,7 @@ double Graph::probeHessianViaAdd(std::mt19937& rng, double eps)//, std::vector<u
     Dvec = Dstar;
     
     // normalize by Fstar to compile Rayleigh coefficients across multiple graph instances
-    if (solver.info() != Eigen::Success)
+    if (failed || m_solve_failed)
     {
         return -1;
     }
@@ -414,10 +1219,9 @@ double Graph::probeHessianViaAdd(std::mt19937& rng, double eps)//, std::vector<u
     }
 }
 
-std::vector<double> Graph::sampleHSpec([[maybe_unused]] unsigned int nSamples, double eps)
+std::vector<double> Graph::sampleHSpec([[maybe_unused]] unsigned int nSamples, double eps, int nThreads)
 {
-    std::mt19937 rng(m_master_seed);
-    
+    PhaseTimer timer(m_telemetry, Phase::Probe);
     // for probing via edge pruning
 
     // std::vector<unsigned int> aliveEdgeIdx; // (static_cast<unsigned int>(Dvec.size()));
@@ -441,16 +1245,90 @@ std::vector<double> Graph::sampleHSpec([[maybe_unused]] unsigned int nSamples, d
     // }
     
     // for scaling perturbation
-    eigvals.reserve(nSamples);
-    for (unsigned int i = 0; i < nSamples; ++i)
+    // every sample draws from its own stream seeded by (m_master_seed, i),
+    // so the spectrum is bitwise reproducible for any thread count
+    auto sampleRng = [&](unsigned int i)
+    {
+        std::seed_seq seq { m_master_seed, i };
+        return std::mt19937(seq);
+    };
+
+    if (m_probe_solver_type == ProbeSolver::Refactor)
+    {
+        // mutates and restores the graph state, so it has to stay serial
+        eigvals.reserve(nSamples);
+        for (unsigned int i = 0; i < nSamples; ++i)
+        {
+            std::mt19937 rng { sampleRng(i) };
+            eigvals.push_back(probeHessianViaScale(rng, eps));
+            // eigvals.push_back(probeHessianViaAdd(rng, eps)); // DOES NOT WORK AS EXPECTED
+        }
+        return eigvals;
+    }
+
+    prepareProbe();
+    eigvals.resize(nSamples);
+
+#ifdef _OPENMP
+    if (nThreads <= 0) { nThreads = omp_get_max_threads(); }
+#else
+    nThreads = 1;
+#endif
+
+    #pragma omp parallel num_threads(nThreads)
     {
-        eigvals.push_back(probeHessianViaScale(rng, eps));
-        // eigvals.push_back(probeHessianViaAdd(rng, eps)); // DOES NOT WORK AS EXPECTED
+        ProbeWorkspace ws;
+        initProbeWorkspace(ws);
+
+        #pragma omp for schedule(dynamic)
+        for (unsigned int i = 0; i < nSamples; ++i)
+        {
+            std::mt19937 rng { sampleRng(i) };
+            eigvals[i] = (m_probe_solver_type == ProbeSolver::Adjoint) ? probeHessianExact(rng, ws)
+                                                                       : probeHessianViaScale(rng, eps, ws);
+        }
     }
 
     return eigvals;
 }
 
+Spectrum::SpectralDensity Graph::spectralDensity(unsigned int nProbes, unsigned int nSteps, int nThreads)
+{
+    PhaseTimer timer(m_telemetry, Phase::Probe);
+    prepareProbe();
+    std::vector<Spectrum::LanczosResult> results(nProbes);
+
+#ifdef _OPENMP
+    if (nThreads <= 0) { nThreads = omp_get_max_threads(); }
+#else
+    nThreads = 1;
+#endif
+
+    #pragma omp parallel num_threads(nThreads)
+    {
+        ProbeWorkspace ws;
+        initProbeWorkspace(ws);
+        Spectrum::Operator H = [&](const Eigen::VectorXd& x, Eigen::VectorXd& y) { scaledHessianProduct(x, y, ws); };
+
+        #pragma omp for schedule(dynamic)
+        for (unsigned int j = 0; j < nProbes; ++j)
+        {
+            // Rademacher start vector, seeded per probe so results do not depend on the thread count
+            std::seed_seq seq { m_master_seed, j, 0x5eedu };
+            std::mt19937 rng(seq);
+            Eigen::VectorXd v0(Dvec.size());
+            for (unsigned int i = 0; i < Dvec.size(); ++i)
+            {
+                v0(i) = (rng() & 1) ? 1.0 : -1.0;
+            }
+
+            results[j] = Spectrum::lanczos(H, v0, nSteps);
+        }
+    }
+
+    return Spectrum::SpectralDensity(std::move(results));
+}
+
 bool Graph::efficiencyConverged()
 {
     double F_old { efficiency(Dvec - dDvec) };
@@ -459,8 +1337,26 @@ bool Graph::efficiencyConverged()
     return (abs(F - F_old) / F_old) < m_tol;
 }
 
+double Graph::probePrune(unsigned int idx, double eps, ProbeWorkspace& ws) const
+{
+    if (!m_probe_ready) { throw std::logic_error("prepareProbe() must be called before probing"); }
+
+    // rank-one change: CG preconditioned by the converged factor needs about two iterations
+    ws.D = Dvec;
+    ws.D(idx) *= eps;
+    double F { probeFitness(ws.D, ws) };
+
+    return (F - m_probe_Fstar) / m_probe_Fstar;
+}
+
 double Graph::probePrune(unsigned int idx, double eps)
 {
+    if (m_probe_solver_type != ProbeSolver::Refactor)
+    {
+        if (!m_probe_ready) { prepareProbe(); }
+        return probePrune(idx, eps, m_probe_ws);
+    }
+
     solveStep(false);
     double Fstar { dissipation(Dvec) };
 
@@ -7,6 +7,17 @@
 #include <random>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+
+#include "../Spectrum/Spectrum.hpp"
+#include "../EdgeKernel/EdgeKernel.hpp"
+#include "../Multigrid/Multigrid.hpp"
+#include "../Telemetry/Telemetry.hpp"
+#include "../Topology/Topology.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 struct Edge
 {
@@ -18,6 +29,111 @@ struct Edge
     double Q; // flow
 };
 
+// positions of an edge's four Laplacian contributions in a compressed value array (-1 when dropped)
+struct EdgeSlots
+{
+    int ii, jj; // diagonal entries
+    int ij, ji; // off-diagonal entries
+};
+
+// how perturbed systems are solved when probing the Hessian
+enum class ProbeSolver
+{
+    Refactor,       // re-assemble and refactorize the perturbed Laplacian (original behaviour)
+    Preconditioned, // factor the converged Laplacian once and run CG preconditioned by that factor
+    Adjoint         // no finite differences: exact second derivative from adjoint solves (eps is ignored)
+};
+
+// time stepping of the adaptation law
+enum class Integrator
+{
+    Euler,           // fixed-step forward Euler (original behaviour)
+    BogackiShampine, // adaptive explicit RK3(2) with error control, reuses its last stage (FSAL)
+    Exponential      // adaptive exponential RK2 (ETD2), the linear decay -beta D is integrated exactly
+};
+
+// how the pressures of each step are solved
+enum class PressureSolver
+{
+    Cholesky, // sparse LDL^T factorization of the reduced Laplacian (original behaviour)
+    Multigrid // CG preconditioned by a geometric multigrid V-cycle, warm-started from the last pressures, tolerance
+              // following the relative change of the conductances (mid-size and large lattices)
+};
+
+// work done by the integrator so far
+struct IntegratorStats
+{
+    std::size_t steps { 0 };      // accepted steps
+    std::size_t rejected { 0 };   // steps repeated with a smaller step size
+    std::size_t solves { 0 };     // pressure solves
+    std::size_t factorizations { 0 }; // Cholesky factorizations (fewer than `solves` when the factor is reused)
+    std::size_t iterations { 0 }; // CG iterations or refinement sweeps of the iterative pressure solves
+    int lastIterations { 0 };     // of the last pressure solve
+    double lastTolerance { 0.0 }; // relative error the last iterative solve was asked for
+    double time { 0.0 };          // integrated model time
+    double h { 0.0 };             // current step size
+    double lastH { 0.0 };         // size of the last accepted step
+
+    double refactorRate() const { return solves > 0 ? static_cast<double>(factorizations) / static_cast<double>(solves) : 0.0; }
+};
+
+// model parameters (defaults are the values the ensembles have been run with)
+struct Parameters
+{
+    unsigned int nSources { 30 }; // previously 7
+    double D0 { 0.1 };
+    double tol { 1e-8 }; // for convergence (previously 1e-8, 1e-12 for `clamp_2`)
+    double D_min { 1e-14 };
+    double c_t { 2.0 }; // previously 0.0
+    // adaptation law dD/dt = alpha |Q|^gamma / (1 + |Q|^gamma) - beta D
+    double alpha { 100.0 };
+    double beta { 10.0 };
+    double gamma { 3.0 };
+    EdgeKernel::GrowthLaw law { EdgeKernel::GrowthLaw::Sigmoid };
+    double costExponent { 0.5 }; // fitness sum Q^2/D + c_t D^costExponent
+};
+
+// removal of edges stuck at the conductance floor from the linear system
+struct PruneOptions
+{
+    bool enabled { false };
+    double threshold { 1e-10 }; // edges at or below this conductance count as dead (negligible next to the O(1) live edges)
+    double patience { 0.5 }; // model time an edge has to stay dead before it is pruned (20 steps of the default `DT`)
+    unsigned int interval { 10 }; // steps between pruning passes (each pass re-analyzes the sparsity pattern)
+};
+
+// reuse of the last Cholesky factor once the conductances barely change: the pressures are found by iterative
+// refinement against the current Laplacian and the factor is only refreshed when that stops paying off
+struct FactorReuseOptions
+{
+    bool enabled { false };
+    double drift { 1e-3 }; // relative change |D - D_f| / |D_f| since the factorization beyond which it is refreshed
+    double contraction { 0.25 }; // every sweep has to shrink the error estimate at least by this factor
+    unsigned int maxSweeps { 4 }; // refinement sweeps before giving up and refactoring
+};
+
+// how a graph is evolved besides its seed, lattice and parameters: everything else that changes the trajectory
+// (part of the `StateStore` key)
+struct EvolutionSettings
+{
+    Integrator integrator { Integrator::Euler };
+    double rtol { 1e-3 }; // adaptive integrators only
+    double atol { 1e-10 };
+    PruneOptions pruning {};
+    PressureSolver pressureSolver { PressureSolver::Cholesky };
+    FactorReuseOptions factorReuse {}; // Cholesky solves only
+};
+
+// scratch space of one Hessian probe, one per thread when sampling in parallel
+struct ProbeWorkspace
+{
+    Eigen::SparseMatrix<double> Lr; // perturbed reduced Laplacian (same pattern as `Graph::Lr`)
+    Eigen::VectorXd D, Q, p, pr; // perturbed state
+    Eigen::VectorXd r, z, d, Ld; // CG scratch
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> fallback; // used when CG fails to converge
+    bool fallbackInitialized { false };
+};
+
 struct Node
 {
     glm::fvec2 pos; // for rendering circles/lines
@@ -26,13 +142,17 @@ struct Node
 
 class Graph
 {
+    friend class GraphBatch; // steps many graphs of one lattice on shared storage and writes their state back
+    friend class Checkpoint; // saves and restores the full simulation state
+
 private:
     // Randomness
     uint32_t m_master_seed;
     std::mt19937 m_rng_sources;
     std::mt19937 m_rng_initD;
 
-    unsigned int m_resolution;
+    unsigned int m_resolution; // lattice side (square root of the node count for other topologies)
+    bool m_lattice { true }; // built by `regularLattice` (the geometry `Multigrid` needs)
     unsigned int m_sink_idx;
     std::vector<unsigned int> m_source_ids;
     const unsigned int n_sources { 30 }; // previously 7
@@ -44,6 +164,31 @@ private:
     const double m_tol { 1e-8 }; // for convergence (previously 1e-8, 1e-12 for `clamp_2`)
     const double D_min { 1e-14 };
     const double c_t { 2.0 }; // previously 0.0
+    const double alpha { 100.0 };
+    const double beta { 10.0 };
+    const double gamma { 3.0 };
+    const EdgeKernel::GrowthLaw m_law { EdgeKernel::GrowthLaw::Sigmoid };
+    const double kappa { 0.5 }; // cost exponent
+    const EdgeKernel::Policy& m_policy; // kernels specialized for the law and exponents above
+    std::size_t m_steps { 0 }; // calls to `evolveGraph`
+
+    // time stepping (`dDvec` is always reported as the change over one nominal `dt`, so convergence checks do not depend on the integrator)
+    Integrator m_integrator { Integrator::Euler };
+    double m_rtol { 1e-3 };
+    double m_atol { 1e-10 };
+    IntegratorStats m_stats;
+    Telemetry m_telemetry;
+    double m_fitness_change { 0.0 }; // relative change of the dissipation over the last step (fitness criterion)
+    bool m_fsal { false }; // `m_k[0]` holds the rate at the current `Dvec`
+    double m_E_prev { -1.0 }; // dissipation at the previous accepted state (adaptive integrators)
+    Eigen::VectorXd m_k[4] {}, m_D_stage {}, m_D_new {}; // stage rates and states
+
+    // pruned edges stay in the full-size vectors with D = D_min, Q = 0 and dD = 0, but leave L, Lr and the factorization
+    // (they never regrow: at the floor the growth term is ~(D_min dp)^gamma)
+    PruneOptions m_prune;
+    std::vector<unsigned int> m_alive_edges {}; // edges still in the linear system
+    std::vector<double> m_dead_since {}; // model time at which each edge last dropped to `m_prune.threshold` (-1 while above it)
+    std::size_t m_alive_nodes { 0 };
 
     std::vector<Node> m_nodes;
     std::vector<Edge> m_edges;
@@ -52,41 +197,142 @@ private:
     Eigen::VectorXd p, s; // pressures, sources/sinks
     
     // reduced versions
+    int m_ground_idx { 0 }; // zero-pressure node removed from the reduced system (moves to the sink if pruning isolates it)
+    std::vector<int> m_row; // node index -> row of the reduced system (-1 for the grounded node and pruned nodes)
     Eigen::SparseMatrix<double> Lr;
-    Eigen::VectorXd sr;
+    Eigen::VectorXd sr, pr;
+
+    // sparsity pattern is fixed after `regularLattice`, so each edge's value slots are found once
+    std::vector<EdgeSlots> m_L_slots, m_Lr_slots;
     
     Eigen::VectorXd Dvec, Qvec, dDvec; // vectorized edge attributes for solver
+    EdgeKernel::Endpoints m_endpoints; // live edges as structure of arrays (rebuilt with the Laplacian pattern)
+    double m_dD_norm2 { 0.0 }, m_D_norm2 { 0.0 }; // |dDvec|^2 and |Dvec|^2 of the last update
     
     // Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
     Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+    FactorReuseOptions m_factor_reuse;
+    bool m_factor_valid { false }; // `solver` holds a factor of the current pattern, taken at `m_D_factored`
+    Eigen::VectorXd m_D_factored, m_refine_r, m_refine_z;
+    PressureSolver m_pressure_solver { PressureSolver::Cholesky };
+    Multigrid m_multigrid;
+    bool m_solve_failed { false }; // the last `solvePressures` left no valid pressures (whichever solver ran)
+    // the iterative solve stops at a relative error (energy norm) of `m_solve_eta |dDvec| / |Dvec|`: the pressures need
+    // not be more accurate than the change they drive, which is large early on and tiny close to convergence
+    double m_solve_eta { 1e-2 };
+    double m_solve_tol_min { 1e-13 }, m_solve_tol_max { 1e-6 };
+    const int m_solve_max_iter { 500 };
+
+    // Hessian probing (factor of the converged reduced Laplacian, kept apart from `solver`)
+    ProbeSolver m_probe_solver_type { ProbeSolver::Preconditioned };
+    bool m_probe_ready { false }; // false whenever `Dvec` changed since `prepareProbe`
+    const double m_probe_tol { 1e-15 }; // relative residual, finite differences need near machine precision
+    const int m_probe_max_iter { 50 };
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_probe_factor;
+    Eigen::VectorXd m_probe_pr; // converged reduced pressures (initial guess for every probe)
+    Eigen::VectorXd m_probe_g; // converged pressure drop across each edge
+    Eigen::VectorXd m_probe_grad; // dF/dD at the converged state
+    Eigen::VectorXd m_probe_cost2; // second derivative of the cost term at the converged state
+    double m_probe_Fstar { 0.0 };
+    ProbeWorkspace m_probe_ws;
 
     void regularLattice(const float width, const float height);
+    void fromTopology(const Topology& topology);
+    void buildLaplacianPattern();
+    void numberReducedSystem();
+    void fillReducedSources();
+    void trackDeadEdges();
+    void pruneEdges();
+    void updateNorms();
+    void eulerStep(const double dt);
+    void setState(const Eigen::VectorXd& D, const Eigen::VectorXd& Q, const Eigen::VectorXd& dD);
+    void assembleReduced(const Eigen::VectorXd& D, Eigen::SparseMatrix<double>& A) const;
+    void expandPressures(const Eigen::VectorXd& reduced, Eigen::VectorXd& full) const;
+    void gatherPressures(const Eigen::VectorXd& full, Eigen::VectorXd& reduced) const;
+    double pressureTolerance() const;
+    bool refinePressures(double tol);
+    double probeFitness(const Eigen::VectorXd& D, ProbeWorkspace& ws) const;
+    int preconditionedCG(const Eigen::SparseMatrix<double>& A, const Eigen::VectorXd& b, Eigen::VectorXd& x, ProbeWorkspace& ws) const;
+    double dissipation(const Eigen::VectorXd& Q, const Eigen::VectorXd& D) const;
+    void evaluateRate(Eigen::VectorXd& D, Eigen::VectorXd& f);
+    double errorNorm(const Eigen::VectorXd& err, const Eigen::VectorXd& D_old, const Eigen::VectorXd& D_new) const;
+    void checkFitness(double dt);
+    void acceptStep(double h, double dt);
+    void stepBogackiShampine(const double dt);
+    void stepExponential(const double dt);
     std::vector<unsigned int> rectangularBoundaryIndices();
     std::vector<unsigned int> randomSources(const std::vector<unsigned int>& boundary, unsigned int n);
-public:
-    Graph(uint32_t seed, const float width, const float height, const unsigned int resolution)
+    // parameters and random streams, the network is built by the public constructors
+    Graph(uint32_t seed, const unsigned int resolution, const Parameters& params)
     : m_master_seed { seed }
     , m_rng_sources(seed + 1)
     , m_rng_initD(seed + 2)
     , m_resolution { resolution }
+    , n_sources { params.nSources }
     , I0 { 2.0 * static_cast<double>(resolution) / 4.0 }
+    , D0 { params.D0 }
+    , m_tol { params.tol }
+    , D_min { params.D_min }
+    , c_t { params.c_t }
+    , alpha { params.alpha }
+    , beta { params.beta }
+    , gamma { params.gamma }
+    , m_law { params.law }
+    , kappa { params.costExponent }
+    , m_policy { EdgeKernel::policy(params.law, params.gamma, params.costExponent) }
+    {}
+
+public:
+    Graph(uint32_t seed, const float width, const float height, const unsigned int resolution, const Parameters& params = Parameters{})
+    : Graph(seed, resolution, params)
     {
         std::cout << "Graph init seed : " << m_master_seed << '\n';
         // vector reservations occur depending on graph initialization type
         regularLattice(width, height);
         initLaplacian();
     };
+    // any network of `Topologies` (in the topology's node and edge order, so `Topology::reorder` it first); the source
+    // current scales with the square root of the node count like the lattice's with its side. Not for `GraphBatch`.
+    Graph(uint32_t seed, const Topology& topology, const Parameters& params = Parameters{})
+    : Graph(seed, static_cast<unsigned int>(std::lround(std::sqrt(static_cast<double>(topology.nodeCount())))), params)
+    {
+        std::cout << "Graph init seed : " << m_master_seed << '\n';
+        fromTopology(topology);
+        initLaplacian();
+    };
     
-    std::size_t nodeCount() { return m_nodes.size(); }
-    std::size_t edgeCount() { return m_edges.size(); }
+    std::size_t nodeCount() const { return m_nodes.size(); }
+    std::size_t edgeCount() const { return m_edges.size(); }
     unsigned int resolution() const { return m_resolution; }
-    const std::vector<Node>& nodes() { return m_nodes; }
-    const std::vector<Edge>& edges() { return m_edges; }
-    const Eigen::SparseMatrix<double>& getL() { return L; }
-    const Eigen::VectorXd& getS() { return s; }
-    const Eigen::VectorXd& getD() { return Dvec; }
-    const Eigen::VectorXd& getQ() { return Qvec; }
+    bool isLattice() const { return m_lattice; }
+    uint32_t seed() const { return m_master_seed; }
+    std::size_t steps() const { return m_steps; }
+    Parameters parameters() const { return Parameters{ n_sources, D0, m_tol, D_min, c_t, alpha, beta, gamma, m_law, kappa }; }
+    EdgeKernel::Coefficients coefficients() const { return EdgeKernel::Coefficients{ alpha, beta, gamma, c_t, kappa, D_min }; }
+    const std::vector<Node>& nodes() const { return m_nodes; }
+    const std::vector<Edge>& edges() const { return m_edges; }
+    const Eigen::SparseMatrix<double>& getL() const { return L; }
+    const Eigen::VectorXd& getS() const { return s; }
+    const Eigen::VectorXd& getD() const { return Dvec; }
+    const Eigen::VectorXd& getQ() const { return Qvec; }
     bool fitConverged() { return fitnessConverged; }
+    void setProbeSolver(ProbeSolver type) { m_probe_solver_type = type; }
+    void setIntegrator(Integrator type, double rtol = 1e-3, double atol = 1e-10);
+    Integrator integrator() const { return m_integrator; }
+    const IntegratorStats& integratorStats() const { return m_stats; }
+    EvolutionSettings evolutionSettings() const { return EvolutionSettings{ m_integrator, m_rtol, m_atol, m_prune, m_pressure_solver, m_factor_reuse }; }
+    const Telemetry& telemetry() const { return m_telemetry; }
+    void setPruning(const PruneOptions& options) { m_prune = options; }
+    void setFactorReuse(const FactorReuseOptions& options) { m_factor_reuse = options; }
+    // throws `std::invalid_argument` for `Multigrid` on graphs not built by `regularLattice`
+    void setPressureSolver(PressureSolver type);
+    PressureSolver pressureSolver() const { return m_pressure_solver; }
+    const Multigrid& multigrid() const { return m_multigrid; }
+    // tolerance of the iterative pressure solve: `eta` times the relative change of the conductances, kept within [min, max]
+    void setSolveTolerance(double eta, double min = 1e-13, double max = 1e-6) { m_solve_eta = eta; m_solve_tol_min = min; m_solve_tol_max = max; }
+    int pressureIterations() const { return m_stats.lastIterations; }
+    const std::vector<unsigned int>& aliveEdges() const { return m_alive_edges; }
+    std::size_t aliveNodeCount() const { return m_alive_nodes; }
     
     void initLaplacian();
     void updateLaplacian();
@@ -99,12 +345,30 @@ public:
     double transportCost();
     bool conductanceConverged() const;
     bool efficiencyConverged();
-    Eigen::VectorXd createScalePerturbationVec(std::mt19937& rng, double eps); //, std::vector<unsigned int> aliveIdxs);
+    Eigen::VectorXd randomDirection(std::mt19937& rng) const;
+    Eigen::VectorXd createScalePerturbationVec(std::mt19937& rng, double eps) const; //, std::vector<unsigned int> aliveIdxs);
     double probeHessianViaScale(std::mt19937& rng, double eps); //, std::vector<unsigned int> aliveIdxs);
-    Eigen::VectorXd createAddPerturbationVec(std::mt19937& rng, double eps); //, std::vector<unsigned int> aliveIdxs);
+    Eigen::VectorXd createAddPerturbationVec(std::mt19937& rng, double eps) const; //, std::vector<unsigned int> aliveIdxs);
     double probeHessianViaAdd(std::mt19937& rng, double eps); //, std::vector<unsigned int> aliveIdxs);
     double probePrune(unsigned int idx, double eps);
-    std::vector<double> sampleHSpec([[maybe_unused]] unsigned int nSamples, double eps);
+    std::vector<double> sampleHSpec([[maybe_unused]] unsigned int nSamples, double eps, int nThreads = 0);
+
+    // side-effect-free probes of the converged state (call `prepareProbe` first), safe to run concurrently
+    void prepareProbe();
+    void initProbeWorkspace(ProbeWorkspace& ws) const;
+    double probeHessianViaScale(std::mt19937& rng, double eps, ProbeWorkspace& ws) const;
+    double probeHessianViaAdd(std::mt19937& rng, double eps, ProbeWorkspace& ws) const;
+    double probePrune(unsigned int idx, double eps, ProbeWorkspace& ws) const;
+
+    // exact derivatives of F(D) = sum Q^2/D + c_t D^kappa at the converged state (call `prepareProbe` first)
+    const Eigen::VectorXd& gradient() const { return m_probe_grad; }
+    void hessianVectorProduct(const Eigen::VectorXd& v, Eigen::VectorXd& Hv, ProbeWorkspace& ws) const;
+    double probeHessianExact(std::mt19937& rng, ProbeWorkspace& ws) const;
+    void scaledHessianProduct(const Eigen::VectorXd& x, Eigen::VectorXd& y, ProbeWorkspace& ws) const;
+
+    // eigenvalue density of the operator whose Rayleigh quotients `sampleHSpec` draws,
+    // from `nProbes` stochastic Lanczos quadratures of `nSteps` Hessian-vector products each
+    Spectrum::SpectralDensity spectralDensity(unsigned int nProbes, unsigned int nSteps, int nThreads = 0);
 
     void solveStep(bool checkConvergence = true)
     {
@@ -113,10 +377,28 @@ public:
         computeFlows(checkConvergence);
     }
 
+    // one step of the selected integrator, `dt` is the fixed step of `Euler`
+    // and the initial step/reporting scale of the adaptive integrators
     void evolveGraph(const double dt)
     {
-        solveStep();
-        updateConductances(dt);
+        switch (m_integrator)
+        {
+            case Integrator::Euler:
+                eulerStep(dt);
+                ++m_stats.steps;
+                m_stats.time += dt;
+                m_stats.h = dt;
+                break;
+            case Integrator::BogackiShampine:
+                stepBogackiShampine(dt);
+                break;
+            case Integrator::Exponential:
+                stepExponential(dt);
+                break;
+        }
+        ++m_steps;
+        m_telemetry.record(sqrt(m_dD_norm2 / m_D_norm2), m_fitness_change);
+        if (m_prune.enabled) { trackDeadEdges(); }
     }
 
     void printSpec(const std::vector<double>& eigvals)
@@ -0,0 +1,426 @@
+#include "GraphBatch.hpp"
+
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+void BatchedLDLT::analyzePattern(const Eigen::SparseMatrix<double>& A)
+{
+    m_n = static_cast<int>(A.rows());
+    const std::size_t n { static_cast<std::size_t>(m_n) };
+
+    // a copy whose values are their own slots, so the permuted matrix tells where each entry came from
+    Eigen::SparseMatrix<double> slots { A };
+    slots.makeCompressed();
+    for (Eigen::Index v = 0; v < slots.nonZeros(); ++v) { slots.valuePtr()[v] = static_cast<double>(v); }
+
+    // ordering and permuted upper triangle exactly as `SimplicialLDLT` (AMD returns the inverse permutation)
+    {
+        Eigen::SparseMatrix<double> C;
+        C = slots.selfadjointView<Eigen::Lower>();
+        Eigen::AMDOrdering<int> ordering;
+        ordering(C, m_Pinv);
+    }
+    m_P = m_Pinv.inverse();
+    Eigen::SparseMatrix<double> ap(m_n, m_n);
+    ap.selfadjointView<Eigen::Upper>() = slots.selfadjointView<Eigen::Lower>().twistedBy(m_P);
+
+    // elimination tree and column counts of L
+    std::vector<int> parent(n, -1), tags(n, -1), count(n, 0);
+    for (int k = 0; k < m_n; ++k)
+    {
+        tags[static_cast<std::size_t>(k)] = k;
+        for (Eigen::SparseMatrix<double>::InnerIterator it(ap, k); it; ++it)
+        {
+            int i { static_cast<int>(it.index()) };
+            if (i >= k) { continue; }
+            for (; tags[static_cast<std::size_t>(i)] != k; i = parent[static_cast<std::size_t>(i)])
+            {
+                std::size_t u { static_cast<std::size_t>(i) };
+                if (parent[u] == -1) { parent[u] = k; }
+                ++count[u];
+                tags[u] = k;
+            }
+        }
+    }
+    m_Lp.assign(n + 1, 0);
+    std::partial_sum(count.begin(), count.end(), m_Lp.begin() + 1);
+    m_Li.assign(static_cast<std::size_t>(m_Lp.back()), 0);
+
+    // structural pass of the up-looking factorization: what `factorize` scatters and in which order it eliminates
+    std::vector<int> pattern(n), filled(n, 0);
+    std::fill(tags.begin(), tags.end(), -1);
+    m_scatter_ptr.assign(1, 0);
+    m_row_ptr.assign(1, 0);
+    m_scatter_row.clear();
+    m_scatter_slot.clear();
+    m_row_col.clear();
+    m_row_pos.clear();
+    for (int k = 0; k < m_n; ++k)
+    {
+        int top { m_n };
+        tags[static_cast<std::size_t>(k)] = k;
+        for (Eigen::SparseMatrix<double>::InnerIterator it(ap, k); it; ++it)
+        {
+            int i { static_cast<int>(it.index()) };
+            if (i > k) { continue; }
+            m_scatter_row.push_back(i);
+            m_scatter_slot.push_back(static_cast<int>(it.value()));
+
+            int len { 0 };
+            for (; tags[static_cast<std::size_t>(i)] != k; i = parent[static_cast<std::size_t>(i)])
+            {
+                pattern[static_cast<std::size_t>(len++)] = i;
+                tags[static_cast<std::size_t>(i)] = k;
+            }
+            while (len > 0) { pattern[static_cast<std::size_t>(--top)] = pattern[static_cast<std::size_t>(--len)]; }
+        }
+        for (; top < m_n; ++top)
+        {
+            std::size_t i { static_cast<std::size_t>(pattern[static_cast<std::size_t>(top)]) };
+            int pos { m_Lp[i] + filled[i]++ };
+            m_Li[static_cast<std::size_t>(pos)] = k;
+            m_row_col.push_back(static_cast<int>(i));
+            m_row_pos.push_back(pos);
+        }
+        m_scatter_ptr.push_back(static_cast<int>(m_scatter_row.size()));
+        m_row_ptr.push_back(static_cast<int>(m_row_col.size()));
+    }
+}
+
+bool BatchedLDLT::factorize(const double* values, int lanes)
+{
+    m_lanes = lanes;
+    const std::size_t K { static_cast<std::size_t>(lanes) };
+    const std::size_t n { static_cast<std::size_t>(m_n) };
+    m_Lx.resize(static_cast<std::size_t>(m_Lp.back()) * K);
+    m_diag.resize(n * K);
+    m_y.assign(n * K, 0.0);
+    m_d.resize(K);
+    m_yi.resize(K);
+
+    auto lane = [K](auto* base, int v) { return base + static_cast<std::size_t>(v) * K; };
+    double* d { m_d.data() };
+    double* yi { m_yi.data() };
+    bool ok { true };
+
+    for (int k = 0; k < m_n; ++k)
+    {
+        // scatter column k of the permuted matrix into y
+        for (int e = m_scatter_ptr[static_cast<std::size_t>(k)]; e < m_scatter_ptr[static_cast<std::size_t>(k) + 1]; ++e)
+        {
+            double* y { lane(m_y.data(), m_scatter_row[static_cast<std::size_t>(e)]) };
+            const double* a { lane(values, m_scatter_slot[static_cast<std::size_t>(e)]) };
+            #pragma omp simd
+            for (std::size_t l = 0; l < K; ++l) { y[l] += a[l]; }
+        }
+
+        double* yk { lane(m_y.data(), k) };
+        #pragma omp simd
+        for (std::size_t l = 0; l < K; ++l)
+        {
+            d[l] = yk[l];
+            yk[l] = 0.0;
+        }
+
+        // row k of L by a sparse triangular solve
+        for (int r = m_row_ptr[static_cast<std::size_t>(k)]; r < m_row_ptr[static_cast<std::size_t>(k) + 1]; ++r)
+        {
+            const int i { m_row_col[static_cast<std::size_t>(r)] };
+            const int p2 { m_row_pos[static_cast<std::size_t>(r)] };
+
+            double* y { lane(m_y.data(), i) };
+            #pragma omp simd
+            for (std::size_t l = 0; l < K; ++l)
+            {
+                yi[l] = y[l];
+                y[l] = 0.0;
+            }
+            for (int p = m_Lp[static_cast<std::size_t>(i)]; p < p2; ++p)
+            {
+                double* yr { lane(m_y.data(), m_Li[static_cast<std::size_t>(p)]) };
+                const double* lx { lane(m_Lx.data(), p) };
+                #pragma omp simd
+                for (std::size_t l = 0; l < K; ++l) { yr[l] -= lx[l] * yi[l]; }
+            }
+            const double* di { lane(m_diag.data(), i) };
+            double* lki { lane(m_Lx.data(), p2) };
+            #pragma omp simd
+            for (std::size_t l = 0; l < K; ++l)
+            {
+                const double l_ki { yi[l] / di[l] };
+                d[l] -= l_ki * yi[l];
+                lki[l] = l_ki;
+            }
+        }
+
+        double* dk { lane(m_diag.data(), k) };
+        for (std::size_t l = 0; l < K; ++l)
+        {
+            dk[l] = d[l];
+            ok &= (d[l] != 0.0);
+        }
+    }
+
+    return ok;
+}
+
+void BatchedLDLT::solve(const double* b, double* x)
+{
+    const std::size_t K { static_cast<std::size_t>(m_lanes) };
+    auto lane = [K](auto* base, int v) { return base + static_cast<std::size_t>(v) * K; };
+    double* w { m_y.data() };
+
+    // w = P b
+    for (int i = 0; i < m_n; ++i)
+    {
+        double* dst { lane(w, m_P.indices()(i)) };
+        const double* src { lane(b, i) };
+        for (std::size_t l = 0; l < K; ++l) { dst[l] = src[l]; }
+    }
+
+    // unit lower solve by columns
+    for (int i = 0; i < m_n; ++i)
+    {
+        const double* wi { lane(w, i) };
+        for (int p = m_Lp[static_cast<std::size_t>(i)]; p < m_Lp[static_cast<std::size_t>(i) + 1]; ++p)
+        {
+            double* wr { lane(w, m_Li[static_cast<std::size_t>(p)]) };
+            const double* lx { lane(m_Lx.data(), p) };
+            #pragma omp simd
+            for (std::size_t l = 0; l < K; ++l) { wr[l] -= wi[l] * lx[l]; }
+        }
+    }
+
+    // diagonal
+    for (int i = 0; i < m_n; ++i)
+    {
+        double* wi { lane(w, i) };
+        const double* di { lane(m_diag.data(), i) };
+        #pragma omp simd
+        for (std::size_t l = 0; l < K; ++l) { wi[l] = (1.0 / di[l]) * wi[l]; }
+    }
+
+    // unit upper (L^T) solve by rows
+    for (int i = m_n - 1; i >= 0; --i)
+    {
+        double* wi { lane(w, i) };
+        for (int p = m_Lp[static_cast<std::size_t>(i)]; p < m_Lp[static_cast<std::size_t>(i) + 1]; ++p)
+        {
+            const double* wr { lane(w, m_Li[static_cast<std::size_t>(p)]) };
+            const double* lx { lane(m_Lx.data(), p) };
+            #pragma omp simd
+            for (std::size_t l = 0; l < K; ++l) { wi[l] -= lx[l] * wr[l]; }
+        }
+    }
+
+    // x = P^-1 w
+    for (int i = 0; i < m_n; ++i)
+    {
+        double* dst { lane(x, m_Pinv.indices()(i)) };
+        const double* src { lane(w, i) };
+        for (std::size_t l = 0; l < K; ++l) { dst[l] = src[l]; }
+    }
+}
+
+GraphBatch::GraphBatch(const std::vector<uint32_t>& seeds, const float width, const float height, const unsigned int resolution, const Parameters& params)
+: m_graphs {}
+, m_lanes {}
+, m_fit_converged {}
+, m_endpoints {}
+, m_Lr_slots {}
+, m_row {}
+, m_policy { EdgeKernel::policy(params.law, params.gamma, params.costExponent) }
+, m_coeffs {}
+, m_tol { params.tol }
+, m_solver {}
+{
+    if (seeds.empty()) { throw std::invalid_argument("GraphBatch needs at least one seed"); }
+
+    // every graph draws its own initial conductances and sources, the lattice is the same for all of them
+    m_graphs.reserve(seeds.size());
+    for (uint32_t seed : seeds)
+    {
+        m_graphs.push_back(std::make_unique<Graph>(seed, width, height, resolution, params));
+    }
+
+    const Graph& first { *m_graphs.front() };
+    m_endpoints = first.m_endpoints;
+    m_Lr_slots = first.m_Lr_slots;
+    m_row = first.m_row;
+    m_nnz = static_cast<int>(first.Lr.nonZeros());
+    m_coeffs = first.coefficients();
+    m_solver.analyzePattern(first.Lr);
+
+    const std::size_t K { seeds.size() };
+    const std::size_t nEdges { first.m_edges.size() };
+    const std::size_t nRows { static_cast<std::size_t>(m_solver.rows()) };
+    m_lanes.resize(K);
+    std::iota(m_lanes.begin(), m_lanes.end(), std::size_t { 0 });
+    m_fit_converged.assign(K, 0);
+
+    m_D.resize(nEdges * K);
+    m_Q.resize(nEdges * K);
+    m_dD.resize(nEdges * K);
+    m_sr.resize(nRows * K);
+    for (std::size_t b = 0; b < K; ++b)
+    {
+        const Graph& graph { *m_graphs[b] };
+        for (std::size_t k = 0; k < nEdges; ++k)
+        {
+            const Eigen::Index e { static_cast<Eigen::Index>(k) };
+            m_D[k * K + b] = graph.Dvec(e);
+            m_Q[k * K + b] = graph.Qvec(e);
+            m_dD[k * K + b] = graph.dDvec(e);
+        }
+        for (std::size_t r = 0; r < nRows; ++r) { m_sr[r * K + b] = graph.sr(static_cast<Eigen::Index>(r)); }
+    }
+}
+
+void GraphBatch::assembleReduced()
+{
+    // same accumulation order as `Graph::updateLaplacian`, widened to the lanes
+    const std::size_t K { m_lanes.size() };
+    m_Lrval.assign(static_cast<std::size_t>(m_nnz) * K, 0.0);
+    double* val { m_Lrval.data() };
+
+    auto add = [K](double* v, const double* D, double sign)
+    {
+        #pragma omp simd
+        for (std::size_t l = 0; l < K; ++l) { v[l] += sign * D[l]; }
+    };
+
+    for (std::size_t k = 0; k < m_Lr_slots.size(); ++k)
+    {
+        const EdgeSlots& red { m_Lr_slots[k] };
+        const double* D { m_D.data() + k * K };
+        if (red.ii >= 0) { add(val + static_cast<std::size_t>(red.ii) * K, D, 1.0); }
+        if (red.jj >= 0) { add(val + static_cast<std::size_t>(red.jj) * K, D, 1.0); }
+        if (red.ij >= 0)
+        {
+            add(val + static_cast<std::size_t>(red.ij) * K, D, -1.0);
+            add(val + static_cast<std::size_t>(red.ji) * K, D, -1.0);
+        }
+    }
+}
+
+void GraphBatch::solvePressures()
+{
+    const std::size_t K { m_lanes.size() };
+    if (!m_solver.factorize(m_Lrval.data(), static_cast<int>(K)))
+    {
+        std::cerr << "Decomposition Failed" << std::endl;
+        return;
+    }
+
+    m_pr.resize(m_sr.size());
+    m_solver.solve(m_sr.data(), m_pr.data());
+
+    // full pressures, zero at the grounded node
+    m_p.resize(m_row.size() * K);
+    for (std::size_t i = 0; i < m_row.size(); ++i)
+    {
+        double* p { m_p.data() + i * K };
+        const int r { m_row[i] };
+        for (std::size_t l = 0; l < K; ++l) { p[l] = (r < 0) ? 0.0 : m_pr[static_cast<std::size_t>(r) * K + l]; }
+    }
+}
+
+std::vector<std::size_t> GraphBatch::evolve(const double dt)
+{
+    std::vector<std::size_t> done;
+    if (m_lanes.empty()) { return done; }
+
+    assembleReduced();
+    solvePressures();
+
+    const std::size_t K { m_lanes.size() };
+    m_sums.resize(K);
+    m_policy.eulerStepBatch(m_endpoints, static_cast<int>(K), m_p.data(), m_D.data(), m_Q.data(), m_dD.data(), m_coeffs, dt, m_sums.data());
+    ++m_steps;
+    m_time += dt;
+
+    // the convergence tests of `Graph::eulerStep` and `Graph::conductanceConverged`, per lane
+    std::vector<char> converged(K, 0);
+    for (std::size_t l = 0; l < K; ++l)
+    {
+        const EdgeKernel::Sums& sums { m_sums[l] };
+        if ((sums.F - sums.F_old) / sums.F_old < m_tol) { m_fit_converged[l] = 1; }
+        converged[l] = m_fit_converged[l] && std::sqrt(sums.dD2 / sums.D2) < m_tol;
+        if (converged[l]) { done.push_back(m_lanes[l]); }
+    }
+
+    if (!done.empty()) { retire(converged, dt); }
+    return done;
+}
+
+void GraphBatch::retire(const std::vector<char>& converged, double dt)
+{
+    const std::size_t K { m_lanes.size() };
+    const std::size_t nEdges { m_Lr_slots.size() };
+    Eigen::VectorXd D(static_cast<Eigen::Index>(nEdges)), Q(D.size()), dD(D.size());
+
+    std::vector<char> keep(K, 1);
+    for (std::size_t l = 0; l < K; ++l)
+    {
+        if (!converged[l]) { continue; }
+        keep[l] = 0;
+
+        for (std::size_t k = 0; k < nEdges; ++k)
+        {
+            const Eigen::Index e { static_cast<Eigen::Index>(k) };
+            D(e) = m_D[k * K + l];
+            Q(e) = m_Q[k * K + l];
+            dD(e) = m_dD[k * K + l];
+        }
+
+        // the graph ends up as if it had run `evolveGraph(dt)` itself
+        Graph& graph { *m_graphs[m_lanes[l]] };
+        graph.setState(D, Q, dD);
+        graph.m_dD_norm2 = m_sums[l].dD2;
+        graph.m_D_norm2 = m_sums[l].D2;
+        graph.fitnessConverged = true;
+        graph.m_steps = m_steps;
+        graph.m_stats.steps = m_steps;
+        graph.m_stats.solves += m_steps;
+        graph.m_stats.factorizations += m_steps;
+        graph.m_stats.time = m_time;
+        graph.m_stats.h = dt;
+    }
+
+    compact(keep);
+}
+
+void GraphBatch::compact(const std::vector<char>& keep)
+{
+    // drop the lanes of graphs that left the batch
+    const std::size_t K { m_lanes.size() };
+    std::vector<std::size_t> kept;
+    for (std::size_t l = 0; l < K; ++l) { if (keep[l]) { kept.push_back(l); } }
+    const std::size_t K2 { kept.size() };
+
+    auto pack = [&](std::vector<double>& v)
+    {
+        const std::size_t entries { v.size() / K };
+        std::vector<double> packed(entries * K2);
+        for (std::size_t k = 0; k < entries; ++k)
+        {
+            for (std::size_t l = 0; l < K2; ++l) { packed[k * K2 + l] = v[k * K + kept[l]]; }
+        }
+        v.swap(packed);
+    };
+    pack(m_D);
+    pack(m_Q);
+    pack(m_dD);
+    pack(m_sr);
+
+    std::vector<std::size_t> lanes(K2);
+    std::vector<char> fit(K2);
+    for (std::size_t l = 0; l < K2; ++l)
+    {
+        lanes[l] = m_lanes[kept[l]];
+        fit[l] = m_fit_converged[kept[l]];
+    }
+    m_lanes.swap(lanes);
+    m_fit_converged.swap(fit);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Sparse>
+
+#include "../Graph/Graph.hpp"
+#include "../EdgeKernel/EdgeKernel.hpp"
+
+// LDL^T factorizations of many symmetric matrices with one sparsity pattern, values interleaved by lane
+// (lane l of value v at v * lanes + l). Ordering, elimination tree, the pattern of L and the row patterns
+// of the up-looking algorithm are computed once by `analyzePattern`; `factorize` and `solve` then run the
+// numeric part of `Eigen::SimplicialLDLT` (same ordering, same operation order) with every scalar operation
+// widened to all lanes.
+class BatchedLDLT
+{
+private:
+    using Permutation = Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int>;
+
+    int m_n { 0 };
+    int m_lanes { 0 };
+    Permutation m_P {}, m_Pinv {};
+
+    // entries of column k of the permuted upper triangle: row and slot in the value array of the original matrix
+    std::vector<int> m_scatter_ptr {}, m_scatter_row {}, m_scatter_slot {};
+    // row k of L in the order it is computed: column i of the entry and its position in `m_Lx`
+    std::vector<int> m_row_ptr {}, m_row_col {}, m_row_pos {};
+    // strictly lower part of L by columns
+    std::vector<int> m_Lp {}, m_Li {};
+
+    std::vector<double> m_Lx {}, m_diag {}, m_y {}, m_d {}, m_yi {};
+
+public:
+    // `A` must be symmetric with both triangles stored (only the pattern is used)
+    void analyzePattern(const Eigen::SparseMatrix<double>& A);
+    // `values` holds `lanes` copies of the value array of the analyzed matrix; false if a pivot vanished
+    bool factorize(const double* values, int lanes);
+    // x = A^-1 b for every lane (interleaved, `x` may alias `b`)
+    void solve(const double* b, double* x);
+
+    int rows() const { return m_n; }
+    int lanes() const { return m_lanes; }
+};
+
+// Lock-step forward Euler evolution of many seeds on the same lattice. Every graph of the batch shares
+// the lattice (and so the sparsity pattern of its reduced Laplacian), so one symbolic factorization serves
+// all of them, and per-edge and per-node quantities are stored interleaved across seeds so the Laplacian
+// assembly, the factorization and the edge kernel vectorize across graphs rather than along edges.
+// Graphs leave the batch as they converge: their state is written back to their `Graph`, which can then be
+// probed and exported as usual. Batches always use `Integrator::Euler` and never prune (pruning would give
+// each graph its own pattern).
+class GraphBatch
+{
+private:
+    std::vector<std::unique_ptr<Graph>> m_graphs; // per seed, holds the initial state and receives the final one
+    std::vector<std::size_t> m_lanes; // graph of each lane still being evolved
+    std::vector<char> m_fit_converged; // per lane
+
+    // lattice shared by every graph (taken from the first)
+    EdgeKernel::Endpoints m_endpoints;
+    std::vector<EdgeSlots> m_Lr_slots;
+    std::vector<int> m_row;
+    int m_nnz { 0 };
+    const EdgeKernel::Policy& m_policy;
+    EdgeKernel::Coefficients m_coeffs;
+    double m_tol;
+
+    // interleaved state, `m_lanes.size()` values per edge, node or matrix entry
+    std::vector<double> m_D {}, m_Q {}, m_dD {};
+    std::vector<double> m_Lrval {}, m_sr {}, m_pr {}, m_p {};
+    std::vector<EdgeKernel::Sums> m_sums {};
+    BatchedLDLT m_solver;
+
+    std::size_t m_steps { 0 };
+    double m_time { 0.0 };
+
+    void assembleReduced();
+    void solvePressures();
+    void retire(const std::vector<char>& converged, double dt);
+    void compact(const std::vector<char>& keep);
+
+public:
+    GraphBatch(const std::vector<uint32_t>& seeds, const float width, const float height, const unsigned int resolution, const Parameters& params = Parameters{});
+
+    std::size_t size() const { return m_graphs.size(); }
+    std::size_t activeCount() const { return m_lanes.size(); }
+    std::size_t steps() const { return m_steps; }
+    Graph& graph(std::size_t b) { return *m_graphs[b]; }
+
+    // one Euler step of every graph still in the batch; returns the graphs that converged with it,
+    // whose state (conductances, flows, step count) has been written back to `graph(b)`
+    std::vector<std::size_t> evolve(const double dt);
+};
@@ -0,0 +1,189 @@
+#include "Manifest.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include "../Utilities/Utilities.hpp"
+
+namespace
+{
+    void fail(const std::string& what)
+    {
+        throw std::ios_base::failure(what + ": " + std::strerror(errno));
+    }
+
+    bool sameParameters(const Parameters& a, const Parameters& b)
+    {
+        return a.nSources == b.nSources && a.D0 == b.D0 && a.tol == b.tol && a.D_min == b.D_min && a.c_t == b.c_t
+            && a.alpha == b.alpha && a.beta == b.beta && a.gamma == b.gamma && a.law == b.law && a.costExponent == b.costExponent;
+    }
+
+    // the same runs, whatever their seeds (a restart draws new ones for the networks it has not stored yet)
+    bool samePlan(const std::vector<Task>& a, const std::vector<Task>& b)
+    {
+        if (a.size() != b.size()) { return false; }
+        for (std::size_t k = 0; k < a.size(); ++k)
+        {
+            if (a[k].id != b[k].id || a[k].resolution != b[k].resolution || a[k].dt != b[k].dt) { return false; }
+        }
+        return true;
+    }
+}
+
+TaskClaim& TaskClaim::operator=(TaskClaim&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_fd = other.m_fd;
+        m_id = other.m_id;
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+void TaskClaim::release()
+{
+    if (m_fd < 0) { return; }
+    ::flock(m_fd, LOCK_UN);
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+SweepManifest::SweepManifest(const std::string& directory, const std::vector<Task>& plan, const Parameters& params)
+: m_directory { directory }
+, m_params { params }
+, m_tasks {}
+{
+    std::filesystem::create_directories(m_directory + "/claims");
+    std::filesystem::create_directories(m_directory + "/done");
+
+    // the plan is linked into place, so of two processes starting the same sweep only one plan survives
+    const std::string filename { m_directory + "/manifest.txt" };
+    if (!std::filesystem::exists(filename))
+    {
+        m_tasks = plan;
+        const std::string temporary { filename + ".tmp." + std::to_string(::getpid()) };
+        write(temporary);
+        const bool linked { ::link(temporary.c_str(), filename.c_str()) == 0 };
+        const int error { errno };
+        std::remove(temporary.c_str());
+        if (linked) { return; }
+        if (error != EEXIST) { errno = error; fail("Failed to create " + filename); }
+    }
+
+    read(filename);
+    if (!sameParameters(m_params, params))
+    {
+        throw std::invalid_argument(filename + " plans a sweep of other parameters");
+    }
+    if (!samePlan(m_tasks, plan))
+    {
+        throw std::invalid_argument(filename + " plans " + std::to_string(m_tasks.size()) + " runs of another resolution, dt or count");
+    }
+}
+
+void SweepManifest::write(const std::string& filename) const
+{
+    std::ostringstream os;
+    os << std::setprecision(17);
+    os << "# sweep manifest" << '\n';
+    os << "# parameters: nSources D0 tol D_min c_t alpha beta gamma law costExponent" << '\n';
+    os << m_params.nSources << ' ' << m_params.D0 << ' ' << m_params.tol << ' ' << m_params.D_min << ' ' << m_params.c_t << ' '
+       << m_params.alpha << ' ' << m_params.beta << ' ' << m_params.gamma << ' ' << static_cast<uint32_t>(m_params.law) << ' '
+       << m_params.costExponent << '\n';
+    os << "# runs: id seed resolution (half) dt" << '\n';
+    for (const Task& task : m_tasks)
+    {
+        os << task.id << ' ' << task.seed << ' ' << task.resolution << ' ' << task.dt << '\n';
+    }
+    Utilities::writeSynced(filename, os.str());
+}
+
+void SweepManifest::read(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) { fail("Failed to open " + filename); }
+
+    m_tasks.clear();
+    bool haveParameters { false };
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line.front() == '#') { continue; }
+        std::istringstream is(line);
+        if (!haveParameters)
+        {
+            uint32_t law { 0 };
+            is >> m_params.nSources >> m_params.D0 >> m_params.tol >> m_params.D_min >> m_params.c_t
+               >> m_params.alpha >> m_params.beta >> m_params.gamma >> law >> m_params.costExponent;
+            m_params.law = static_cast<EdgeKernel::GrowthLaw>(law);
+            haveParameters = true;
+        }
+        else
+        {
+            Task task {};
+            is >> task.id >> task.seed >> task.resolution >> task.dt;
+            m_tasks.push_back(task);
+        }
+        if (is.fail()) { throw std::ios_base::failure(filename + " is malformed: " + line); }
+    }
+    if (!haveParameters) { throw std::ios_base::failure(filename + " is malformed"); }
+}
+
+std::vector<Task> SweepManifest::pending() const
+{
+    std::vector<Task> tasks;
+    for (const Task& task : m_tasks)
+    {
+        if (!done(task.id)) { tasks.push_back(task); }
+    }
+    return tasks;
+}
+
+bool SweepManifest::done(std::size_t id) const
+{
+    return std::filesystem::exists(donePath(id));
+}
+
+TaskClaim SweepManifest::claim(std::size_t id) const
+{
+    if (done(id)) { return TaskClaim{}; }
+
+    const std::string filename { claimPath(id) };
+    int fd { ::open(filename.c_str(), O_RDWR | O_CREAT, 0644) };
+    if (fd < 0) { fail("Failed to open " + filename); }
+    while (::flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        if (errno == EINTR) { continue; }
+        const int error { errno };
+        ::close(fd);
+        if (error == EWOULDBLOCK) { return TaskClaim{}; }
+        errno = error;
+        fail("Failed to lock " + filename);
+    }
+
+    // the previous holder may have finished it in between
+    TaskClaim claim(fd, id);
+    if (done(id)) { claim.release(); }
+    return claim;
+}
+
+void SweepManifest::complete(TaskClaim& claim, const Task& task, std::size_t steps) const
+{
+    // only the holder writes the marker, so its temporary name cannot collide
+    const std::string filename { donePath(claim.id()) };
+    Utilities::replaceSynced(filename, std::to_string(task.seed) + ' ' + std::to_string(steps) + '\n');
+    claim.release();
+}
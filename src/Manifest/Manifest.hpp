@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../Graph/Graph.hpp"
+#include "../Scheduler/Scheduler.hpp"
+
+// Exclusive hold on one task of a sweep: an open, `flock`ed file in the manifest's `claims/` directory. The lock dies
+// with its holder (also when the process crashes), so a claim never has to be cleaned up after an interruption.
+class TaskClaim
+{
+private:
+    int m_fd { -1 };
+    std::size_t m_id { 0 };
+
+    friend class SweepManifest;
+    TaskClaim(int fd, std::size_t id) : m_fd { fd }, m_id { id } {}
+
+public:
+    TaskClaim() = default;
+    ~TaskClaim() { release(); }
+
+    TaskClaim(TaskClaim&& other) noexcept : m_fd { other.m_fd }, m_id { other.m_id } { other.m_fd = -1; }
+    TaskClaim& operator=(TaskClaim&& other) noexcept;
+    TaskClaim(const TaskClaim&) = delete;
+    TaskClaim& operator=(const TaskClaim&) = delete;
+
+    explicit operator bool() const { return m_fd >= 0; }
+    std::size_t id() const { return m_id; }
+    // gives the task back without marking it done
+    void release();
+};
+
+// Planned runs of a headless ensemble, kept in a directory so an interrupted sweep picks up where it stopped:
+//   manifest.txt : the model parameters of the sweep, then one line per run (id, seed, half resolution, dt)
+//   claims/<id>  : locked by the worker running the task (any process on the machine, see `TaskClaim`)
+//   done/<id>    : written once the task's result is stored (synced and renamed into place, so it is all or nothing)
+// The first process to open a directory writes the plan it was given; every later one (a restart, or a second process
+// joining the sweep) reads it back instead, so task ids and seeds stay the same whatever the core count. The plan
+// given to a later one has to have the same runs (ids, resolutions and dt, in order); only its seeds are ignored.
+// A task whose result was stored but whose marker was not yet written is run again: the converged network comes back
+// from the `StateStore`, and the store then holds its record twice (`resultstore.py` keeps the last one).
+class SweepManifest
+{
+private:
+    std::string m_directory;
+    Parameters m_params;
+    std::vector<Task> m_tasks;
+
+    std::string claimPath(std::size_t id) const { return m_directory + "/claims/" + std::to_string(id); }
+    std::string donePath(std::size_t id) const { return m_directory + "/done/" + std::to_string(id); }
+    void write(const std::string& filename) const;
+    void read(const std::string& filename);
+
+public:
+    // throws if the directory holds a sweep of other parameters or another plan
+    SweepManifest(const std::string& directory, const std::vector<Task>& plan, const Parameters& params);
+
+    const std::vector<Task>& tasks() const { return m_tasks; }
+    // planned tasks without a done marker, in plan order
+    std::vector<Task> pending() const;
+    bool done(std::size_t id) const;
+
+    // empty if the task is done or being run by another worker
+    TaskClaim claim(std::size_t id) const;
+    // writes the done marker and releases the claim
+    void complete(TaskClaim& claim, const Task& task, std::size_t steps) const;
+
+    const std::string& directory() const { return m_directory; }
+};
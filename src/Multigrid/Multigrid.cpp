@@ -0,0 +1,610 @@
+#include "Multigrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    // levels are coarsened until the dense factorization of the last one is negligible
+    constexpr int coarsestNodes { 64 };
+
+    double dot(const std::vector<double>& a, const std::vector<double>& b)
+    {
+        return std::inner_product(a.begin(), a.end(), b.begin(), 0.0);
+    }
+
+    // conductance of the link between padded nodes I and J of a level (9-point neighbours)
+    void addLink(std::vector<double>& cE, std::vector<double>& cN, std::vector<double>& cNE, std::vector<double>& cNW, int sx, int I, int J, double w)
+    {
+        if (J < I) { std::swap(I, J); }
+        const int d { J - I };
+        std::size_t i { static_cast<std::size_t>(I) };
+        if (d == sx) { cE[i] += w; }
+        else if (d == 1) { cN[i] += w; }
+        else if (d == sx + 1) { cNE[i] += w; }
+        else if (d == sx - 1) { cNW[static_cast<std::size_t>(J)] += w; } // I is the north-west neighbour of J
+        else { throw std::logic_error("Multigrid: coarse link beyond the 9-point stencil"); }
+    }
+}
+
+double Multigrid::Level::conductance(int k, int dx, int dy) const
+{
+    auto at = [](const std::vector<double>& c, int i) { return c[static_cast<std::size_t>(i)]; };
+    if (dy == 0) { return dx > 0 ? at(cE, k) : at(cE, k - sx); }
+    if (dx == 0) { return dy > 0 ? at(cN, k) : at(cN, k - 1); }
+    if (!ninePoint) { return 0.0; }
+    if (dx == dy) { return dx > 0 ? at(cNE, k) : at(cNE, k - sx - 1); }
+    return dx < 0 ? at(cNW, k) : at(cNW, k + sx - 1);
+}
+
+void Multigrid::shape(Level& level, int nx, int ny, bool ninePoint) const
+{
+    // values are rebuilt on every setup, `assign` keeps the allocations
+    const std::size_t n { static_cast<std::size_t>((nx + 2) * (ny + 2)) };
+    level.nx = nx;
+    level.ny = ny;
+    level.sx = ny + 2;
+    level.ninePoint = ninePoint;
+    level.cE.assign(n, 0.0);
+    level.cN.assign(n, 0.0);
+    level.cNE.assign(ninePoint ? n : 0, 0.0);
+    level.cNW.assign(ninePoint ? n : 0, 0.0);
+    level.diag.assign(n, 0.0);
+    level.invDiag.assign(n, 0.0);
+    level.x.assign(n, 0.0);
+    level.b.assign(n, 0.0);
+    level.r.assign(n, 0.0);
+}
+
+void Multigrid::setup(int nx, int ny, const EdgeKernel::Endpoints& edges, const double* D, int ground)
+{
+    // level sizes follow the parity of the grounded node, which may move when edges are pruned
+    int gx { ground / ny }, gy { ground % ny };
+    std::size_t nLevels { 0 };
+    while (true)
+    {
+        if (m_levels.size() <= nLevels) { m_levels.emplace_back(); }
+        Level& level { m_levels[nLevels++] };
+        shape(level, nx, ny, nLevels > 1);
+        level.ground = level.index(gx, gy);
+        if (nx * ny <= coarsestNodes || nx < 3 || ny < 3) { break; }
+
+        level.ox = gx & 1;
+        level.oy = gy & 1;
+        level.P.resize(static_cast<std::size_t>(nx * ny));
+        nx = (nx - level.ox + 1) / 2;
+        ny = (ny - level.oy + 1) / 2;
+        gx = (gx - level.ox) / 2;
+        gy = (gy - level.oy) / 2;
+    }
+    m_levels.resize(nLevels);
+
+    // the lattice: link conductances from the edges
+    Level& fine { m_levels.front() };
+    const int nNodes { fine.nx * fine.ny };
+    const bool indexed { !edges.edge.empty() };
+    for (std::size_t a = 0; a < edges.i.size(); ++a)
+    {
+        int i { std::min(edges.i[a], edges.j[a]) };
+        int j { std::max(edges.i[a], edges.j[a]) };
+        double c { D[indexed ? edges.edge[a] : static_cast<int>(a)] };
+        int k { fine.index(i / fine.ny, i % fine.ny) };
+        if (j - i == fine.ny) { fine.cE[static_cast<std::size_t>(k)] = c; }
+        else if (j - i == 1 && j % fine.ny != 0 && j < nNodes) { fine.cN[static_cast<std::size_t>(k)] = c; }
+        else { throw std::invalid_argument("Multigrid: edges do not form a square lattice"); }
+    }
+    finish(fine);
+
+    for (std::size_t l = 0; l + 1 < m_levels.size(); ++l)
+    {
+        interpolation(m_levels[l], m_levels[l + 1]);
+        galerkin(m_levels[l], m_levels[l + 1]);
+        finish(m_levels[l + 1]);
+    }
+    factorCoarsest();
+
+    const std::size_t n { fine.diag.size() };
+    for (std::vector<double>* v : { &m_b, &m_x, &m_r, &m_z, &m_p, &m_q, &m_line_d }) { v->assign(n, 0.0); }
+}
+
+void Multigrid::finish(Level& level) const
+{
+    // every level is the Laplacian of a graph that includes the grounded node, so the diagonal is the sum of
+    // the links and never has to be formed as a (cancelling) difference. Nodes without links (pruned) and the
+    // grounded node are held fixed.
+    for (int X = 0; X < level.nx; ++X)
+    {
+        for (int Y = 0; Y < level.ny; ++Y)
+        {
+            const int k { level.index(X, Y) };
+            double diag { 0.0 };
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                for (int dy = -1; dy <= 1; ++dy) { if (dx != 0 || dy != 0) { diag += level.conductance(k, dx, dy); } }
+            }
+            const std::size_t u { static_cast<std::size_t>(k) };
+            level.diag[u] = diag;
+            level.invDiag[u] = (diag > 0.0 && k != level.ground) ? 1.0 / diag : 0.0;
+        }
+    }
+    factorLines(level);
+}
+
+void Multigrid::interpolation(Level& fine, const Level& coarse)
+{
+    // corner weights (SW, SE, NW, NE of the coarse cell) of every fine point
+    const int nx { fine.nx }, ny { fine.ny };
+    auto cornerExists = [&](int X, int Y, int corner)
+    {
+        int cx { ((X - fine.ox) >> 1) + (corner & 1) };
+        int cy { ((Y - fine.oy) >> 1) + (corner >> 1) };
+        return cx >= 0 && cx < coarse.nx && cy >= 0 && cy < coarse.ny;
+    };
+    // equal weights over the existing corners of `corners` when the operator gives none (isolated points)
+    auto fallback = [&](int X, int Y, std::initializer_list<int> corners, std::array<double, 4>& w)
+    {
+        w = { 0.0, 0.0, 0.0, 0.0 };
+        double n { 0.0 };
+        for (int c : corners) { if (cornerExists(X, Y, c)) { w[static_cast<std::size_t>(c)] = 1.0; n += 1.0; } }
+        for (double& v : w) { v /= n; }
+    };
+    auto pos = [](double c) { return std::max(c, 0.0); };
+
+    // coarse points and points on coarse grid lines first, cell centres use their weights
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int X = 0; X < nx; ++X)
+        {
+            for (int Y = 0; Y < ny; ++Y)
+            {
+                const bool fx { ((X - fine.ox) & 1) != 0 };
+                const bool fy { ((Y - fine.oy) & 1) != 0 };
+                if ((fx && fy) != (pass == 1)) { continue; }
+
+                const int k { fine.index(X, Y) };
+                const std::size_t u { static_cast<std::size_t>(X * ny + Y) };
+                std::array<double, 4>& w { fine.P[u] };
+                auto c = [&](int dx, int dy) { return pos(fine.conductance(k, dx, dy)); };
+
+                if (!fx && !fy) { w = { 1.0, 0.0, 0.0, 0.0 }; }
+                else if (fx && !fy)
+                {
+                    // between two coarse points along x: the columns of the stencil collapsed
+                    double west { c(-1, -1) + c(-1, 0) + c(-1, 1) };
+                    double east { c(1, -1) + c(1, 0) + c(1, 1) };
+                    if (west + east > 0.0) { w = { west / (west + east), east / (west + east), 0.0, 0.0 }; }
+                    else { fallback(X, Y, { 0, 1 }, w); }
+                }
+                else if (!fx && fy)
+                {
+                    double south { c(-1, -1) + c(0, -1) + c(1, -1) };
+                    double north { c(-1, 1) + c(0, 1) + c(1, 1) };
+                    if (south + north > 0.0) { w = { south / (south + north), 0.0, north / (south + north), 0.0 }; }
+                    else { fallback(X, Y, { 0, 2 }, w); }
+                }
+                else
+                {
+                    // cell centre: direct links to the corners plus the links to the four edge points, through their weights
+                    auto P = [&](int dx, int dy) -> std::array<double, 4>
+                    {
+                        int Xn { X + dx }, Yn { Y + dy };
+                        if (Xn < 0 || Xn >= nx || Yn < 0 || Yn >= ny) { return { 0.0, 0.0, 0.0, 0.0 }; }
+                        return fine.P[static_cast<std::size_t>(Xn * ny + Yn)];
+                    };
+                    const std::array<double, 4> pw { P(-1, 0) }, pe { P(1, 0) }, ps { P(0, -1) }, pn { P(0, 1) };
+                    double total { c(-1, -1) + c(0, -1) + c(1, -1) + c(-1, 0) + c(1, 0) + c(-1, 1) + c(0, 1) + c(1, 1) };
+                    if (total > 0.0)
+                    {
+                        w[0] = (c(-1, -1) + c(-1, 0) * pw[0] + c(0, -1) * ps[0]) / total;
+                        w[1] = (c(1, -1) + c(1, 0) * pe[0] + c(0, -1) * ps[1]) / total;
+                        w[2] = (c(-1, 1) + c(-1, 0) * pw[2] + c(0, 1) * pn[0]) / total;
+                        w[3] = (c(1, 1) + c(1, 0) * pe[2] + c(0, 1) * pn[1]) / total;
+                    }
+                    else { fallback(X, Y, { 0, 1, 2, 3 }, w); }
+                }
+            }
+        }
+    }
+}
+
+void Multigrid::galerkin(const Level& fine, Level& coarse)
+{
+    // A_c = P^T A P link by link: a link of conductance c between fine points i and j adds c v v^T with
+    // v = P_i - P_j, i.e. -c v_I v_J to the conductance between I and J (the rows of P sum to one, so
+    // A_c is again a Laplacian and its diagonal follows from the links)
+    const int nx { fine.nx }, ny { fine.ny };
+    const int csx { coarse.sx };
+
+    auto support = [&](int X, int Y, double sign, std::array<int, 8>& idx, std::array<double, 8>& val, int& n)
+    {
+        const std::array<double, 4>& w { fine.P[static_cast<std::size_t>(X * ny + Y)] };
+        const int cx { (X - fine.ox) >> 1 }, cy { (Y - fine.oy) >> 1 };
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            double v { w[static_cast<std::size_t>(corner)] };
+            if (v == 0.0) { continue; }
+            int I { coarse.index(cx + (corner & 1), cy + (corner >> 1)) };
+            int m { 0 };
+            while (m < n && idx[static_cast<std::size_t>(m)] != I) { ++m; }
+            if (m == n) { idx[static_cast<std::size_t>(n)] = I; val[static_cast<std::size_t>(n++)] = 0.0; }
+            val[static_cast<std::size_t>(m)] += sign * v;
+        }
+    };
+
+    auto link = [&](int X1, int Y1, int X2, int Y2, double c)
+    {
+        if (c == 0.0) { return; }
+        std::array<int, 8> idx {};
+        std::array<double, 8> val {};
+        int n { 0 };
+        support(X1, Y1, 1.0, idx, val, n);
+        support(X2, Y2, -1.0, idx, val, n);
+        for (int a = 0; a < n; ++a)
+        {
+            const double va { val[static_cast<std::size_t>(a)] };
+            const int Ia { idx[static_cast<std::size_t>(a)] };
+            for (int b = a + 1; b < n; ++b)
+            {
+                double w { -c * va * val[static_cast<std::size_t>(b)] };
+                if (w != 0.0) { addLink(coarse.cE, coarse.cN, coarse.cNE, coarse.cNW, csx, Ia, idx[static_cast<std::size_t>(b)], w); }
+            }
+        }
+    };
+
+    for (int X = 0; X < nx; ++X)
+    {
+        for (int Y = 0; Y < ny; ++Y)
+        {
+            const std::size_t k { static_cast<std::size_t>(fine.index(X, Y)) };
+            if (X + 1 < nx) { link(X, Y, X + 1, Y, fine.cE[k]); }
+            if (Y + 1 < ny) { link(X, Y, X, Y + 1, fine.cN[k]); }
+            if (fine.ninePoint)
+            {
+                if (X + 1 < nx && Y + 1 < ny) { link(X, Y, X + 1, Y + 1, fine.cNE[k]); }
+                if (X > 0 && Y + 1 < ny) { link(X, Y, X - 1, Y + 1, fine.cNW[k]); }
+            }
+        }
+    }
+}
+
+void Multigrid::factorCoarsest()
+{
+    // dense LDL^T of the active nodes, again with the pivots as sums of links (Grassmann, Taksar and Heyman):
+    // `W` holds the conductances among the nodes still to be eliminated, `g` their links to held nodes and
+    // to the eliminated ones
+    const Level& level { m_levels.back() };
+    m_coarse_row.assign(level.diag.size(), -1);
+    m_coarse_node.clear();
+    for (int X = 0; X < level.nx; ++X)
+    {
+        for (int Y = 0; Y < level.ny; ++Y)
+        {
+            const int k { level.index(X, Y) };
+            if (level.invDiag[static_cast<std::size_t>(k)] > 0.0)
+            {
+                m_coarse_row[static_cast<std::size_t>(k)] = static_cast<int>(m_coarse_node.size());
+                m_coarse_node.push_back(k);
+            }
+        }
+    }
+
+    const std::size_t n { m_coarse_node.size() };
+    std::vector<double>& W { m_coarse_L };
+    std::vector<double>& g { m_coarse_pivot };
+    W.assign(n * n, 0.0);
+    g.assign(n, 0.0);
+    m_coarse_y.resize(n);
+    for (std::size_t r = 0; r < n; ++r)
+    {
+        const int k { m_coarse_node[r] };
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                if (dx == 0 && dy == 0) { continue; }
+                const double c { level.conductance(k, dx, dy) };
+                const int rn { m_coarse_row[static_cast<std::size_t>(k + dx * level.sx + dy)] };
+                if (rn >= 0) { W[r * n + static_cast<std::size_t>(rn)] = c; }
+                else { g[r] += c; }
+            }
+        }
+    }
+
+    for (std::size_t e = 0; e < n; ++e)
+    {
+        double pivot { g[e] };
+        for (std::size_t j = e + 1; j < n; ++j) { pivot += W[e * n + j]; }
+        const double inv { pivot > 0.0 ? 1.0 / pivot : 0.0 }; // a component without any link to the ground stays at zero
+        for (std::size_t i = e + 1; i < n; ++i)
+        {
+            const double w { W[i * n + e] * inv };
+            if (w == 0.0) { continue; }
+            for (std::size_t j = e + 1; j < n; ++j) { if (j != i) { W[i * n + j] += w * W[e * n + j]; } }
+            g[i] += w * g[e];
+            W[i * n + e] = w; // multiplier, the strict lower triangle becomes L
+        }
+        g[e] = inv; // 1 / D of the factorization
+    }
+}
+
+void Multigrid::apply(const Level& level, const std::vector<double>& x, std::vector<double>& y) const
+{
+    // y = A x on the active nodes as a sum of link currents (x is zero on the others)
+    const std::size_t s { static_cast<std::size_t>(level.sx) };
+    for (int X = 0; X < level.nx; ++X)
+    {
+        for (int Y = 0; Y < level.ny; ++Y)
+        {
+            const std::size_t k { static_cast<std::size_t>(level.index(X, Y)) };
+            const double xk { x[k] };
+            double Ax { level.cE[k] * (xk - x[k + s]) + level.cE[k - s] * (xk - x[k - s]) + level.cN[k] * (xk - x[k + 1]) + level.cN[k - 1] * (xk - x[k - 1]) };
+            if (level.ninePoint)
+            {
+                Ax += level.cNE[k] * (xk - x[k + s + 1]) + level.cNE[k - s - 1] * (xk - x[k - s - 1]) + level.cNW[k] * (xk - x[k - s + 1]) + level.cNW[k + s - 1] * (xk - x[k + s - 1]);
+            }
+            y[k] = level.invDiag[k] > 0.0 ? Ax : 0.0;
+        }
+    }
+}
+
+void Multigrid::factorLines(Level& level) const
+{
+    // LU of the tridiagonal blocks of the line relaxation in both directions, once per setup. The elimination
+    // runs in the form of Grassmann, Taksar and Heyman: with conductances spanning many decades the pivots of a
+    // piece of line hanging off the rest by edges at the floor are tiny, and `diag - link^2 / pivot` would leave
+    // only rounding error. Instead each pivot is the link to the next node plus the conductance towards
+    // everything off the line (`g`), which only ever accumulates positive terms.
+    const std::size_t n { level.diag.size() }, s { static_cast<std::size_t>(level.sx) };
+    std::vector<double> g(n, 0.0);
+    for (std::size_t dir = 0; dir < 2; ++dir)
+    {
+        const bool alongY { dir == 0 };
+        const std::size_t step { alongY ? 1 : s };
+        const std::vector<double>& link { alongY ? level.cN : level.cE };
+        std::vector<double>& L { level.lineLower[dir] };
+        std::vector<double>& C { level.lineUpper[dir] };
+        std::vector<double>& inv { level.lineInv[dir] };
+        L.assign(n, 0.0);
+        C.assign(n, 0.0);
+        inv.assign(n, 0.0);
+
+        // in the order of the elimination, x-lines side by side
+        auto eliminate = [&](std::size_t k)
+        {
+            if (level.invDiag[k] == 0.0) { g[k] = 0.0; return; }
+
+            double lower { link[k - step] }, upper { link[k] };
+            double gk { 0.0 }; // links off the line
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    const bool onLine { alongY ? dx == 0 : dy == 0 };
+                    if (!onLine) { gk += level.conductance(static_cast<int>(k), dx, dy); }
+                }
+            }
+            // links to held nodes on the line ground it as well (the ghost layer has no links)
+            if (level.invDiag[k - step] == 0.0) { gk += lower; lower = 0.0; }
+            if (level.invDiag[k + step] == 0.0) { gk += upper; upper = 0.0; }
+            // grounding passed on from the eliminated part of the line through the link to it
+            if (lower != 0.0) { gk += lower * g[k - step] / (g[k - step] + lower); }
+
+            const double pivot { gk + upper };
+            inv[k] = pivot > 0.0 ? 1.0 / pivot : 0.0; // a piece of line without any other link stays put
+            L[k] = lower;
+            C[k] = upper * inv[k];
+            g[k] = gk;
+        };
+
+        for (int X = 0; X < level.nx; ++X)
+        {
+            for (int Y = 0; Y < level.ny; ++Y) { eliminate(static_cast<std::size_t>(level.index(X, Y))); }
+        }
+    }
+}
+
+void Multigrid::relaxLines(const Level& level, std::vector<double>& x, const std::vector<double>& b, bool alongY, int parity)
+{
+    // exact solves of every other grid line with the lines in between held fixed (zebra line Gauss-Seidel),
+    // with the factors of `factorLines`. Lines along x are solved side by side so memory is still swept along y.
+    const std::size_t dir { alongY ? 0u : 1u };
+    const std::size_t s { static_cast<std::size_t>(level.sx) };
+    const std::size_t step { alongY ? 1 : s };
+    const std::size_t a { alongY ? s : 1 };
+    const std::vector<double>& across { alongY ? level.cE : level.cN }; // links to the neighbouring lines
+    const std::vector<double>& L { level.lineLower[dir] };
+    const std::vector<double>& C { level.lineUpper[dir] };
+    const std::vector<double>& inv { level.lineInv[dir] };
+    std::vector<double>& d { m_line_d };
+
+    // the neighbouring lines go to the right-hand side (inactive nodes have `inv` = 0 and stay at zero)
+    auto forward = [&](std::size_t k)
+    {
+        double rhs { b[k] + across[k] * x[k + a] + across[k - a] * x[k - a] };
+        if (level.ninePoint)
+        {
+            rhs += level.cNE[k] * x[k + s + 1] + level.cNE[k - s - 1] * x[k - s - 1] + level.cNW[k] * x[k - s + 1] + level.cNW[k + s - 1] * x[k + s - 1];
+        }
+        d[k] = (rhs + L[k] * d[k - step]) * inv[k];
+    };
+    auto backward = [&](std::size_t k) { x[k] = d[k] + C[k] * x[k + step]; };
+
+    const int nx { level.nx }, ny { level.ny };
+    if (alongY)
+    {
+        for (int X = parity; X < nx; X += 2)
+        {
+            for (int Y = 0; Y < ny; ++Y) { forward(static_cast<std::size_t>(level.index(X, Y))); }
+            for (int Y = ny - 1; Y >= 0; --Y) { backward(static_cast<std::size_t>(level.index(X, Y))); }
+        }
+    }
+    else
+    {
+        for (int X = 0; X < nx; ++X)
+        {
+            for (int Y = parity; Y < ny; Y += 2) { forward(static_cast<std::size_t>(level.index(X, Y))); }
+        }
+        for (int X = nx - 1; X >= 0; --X)
+        {
+            for (int Y = parity; Y < ny; Y += 2) { backward(static_cast<std::size_t>(level.index(X, Y))); }
+        }
+    }
+}
+
+void Multigrid::smooth(const Level& level, std::vector<double>& x, const std::vector<double>& b, bool forward)
+{
+    // alternating zebra line relaxation: columns, then rows (in reverse after the coarse correction, so the
+    // V-cycle stays symmetric). Whole lines are relaxed at once because channels of high conductance run along
+    // lines that are not coarse, where the interpolation alone cannot follow them.
+    if (forward)
+    {
+        relaxLines(level, x, b, true, 0);
+        relaxLines(level, x, b, true, 1);
+        relaxLines(level, x, b, false, 0);
+        relaxLines(level, x, b, false, 1);
+    }
+    else
+    {
+        relaxLines(level, x, b, false, 1);
+        relaxLines(level, x, b, false, 0);
+        relaxLines(level, x, b, true, 1);
+        relaxLines(level, x, b, true, 0);
+    }
+}
+
+void Multigrid::cycle(std::size_t l)
+{
+    Level& level { m_levels[l] };
+
+    if (l + 1 == m_levels.size())
+    {
+        const std::size_t n { m_coarse_node.size() };
+        std::vector<double>& y { m_coarse_y };
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            double v { level.b[static_cast<std::size_t>(m_coarse_node[i])] };
+            for (std::size_t j = 0; j < i; ++j) { v += m_coarse_L[i * n + j] * y[j]; }
+            y[i] = v;
+        }
+        for (std::size_t i = 0; i < n; ++i) { y[i] *= m_coarse_pivot[i]; }
+        for (std::size_t i = n; i-- > 0;)
+        {
+            double v { y[i] };
+            for (std::size_t j = i + 1; j < n; ++j) { v += m_coarse_L[j * n + i] * y[j]; }
+            y[i] = v;
+        }
+        std::fill(level.x.begin(), level.x.end(), 0.0);
+        for (std::size_t i = 0; i < n; ++i) { level.x[static_cast<std::size_t>(m_coarse_node[i])] = y[i]; }
+        return;
+    }
+
+    for (int i = 0; i < m_smoothing; ++i) { smooth(level, level.x, level.b, true); }
+
+    apply(level, level.x, level.r);
+    for (std::size_t k = 0; k < level.r.size(); ++k) { level.r[k] = level.b[k] - level.r[k]; }
+
+    // restriction with P^T, coarse correction, prolongation with P. Weights towards corners outside the coarse
+    // grid are zero and their index lands in the ghost layer, so every point takes all four.
+    Level& coarse { m_levels[l + 1] };
+    const std::size_t cs { static_cast<std::size_t>(coarse.sx) };
+    auto corner = [&](int X, int Y) { return static_cast<std::size_t>(coarse.index((X - level.ox) >> 1, (Y - level.oy) >> 1)); };
+
+    std::fill(coarse.b.begin(), coarse.b.end(), 0.0);
+    for (int X = 0; X < level.nx; ++X)
+    {
+        for (int Y = 0; Y < level.ny; ++Y)
+        {
+            const std::array<double, 4>& w { level.P[static_cast<std::size_t>(X * level.ny + Y)] };
+            const double r { level.r[static_cast<std::size_t>(level.index(X, Y))] };
+            const std::size_t c { corner(X, Y) };
+            coarse.b[c] += w[0] * r;
+            coarse.b[c + cs] += w[1] * r;
+            coarse.b[c + 1] += w[2] * r;
+            coarse.b[c + cs + 1] += w[3] * r;
+        }
+    }
+    for (std::size_t k = 0; k < coarse.b.size(); ++k) { if (coarse.invDiag[k] == 0.0) { coarse.b[k] = 0.0; } }
+
+    std::fill(coarse.x.begin(), coarse.x.end(), 0.0);
+    cycle(l + 1);
+
+    for (int X = 0; X < level.nx; ++X)
+    {
+        for (int Y = 0; Y < level.ny; ++Y)
+        {
+            const std::array<double, 4>& w { level.P[static_cast<std::size_t>(X * level.ny + Y)] };
+            const std::size_t c { corner(X, Y) };
+            level.x[static_cast<std::size_t>(level.index(X, Y))] += w[0] * coarse.x[c] + w[1] * coarse.x[c + cs] + w[2] * coarse.x[c + 1] + w[3] * coarse.x[c + cs + 1];
+        }
+    }
+
+    for (int i = 0; i < m_smoothing; ++i) { smooth(level, level.x, level.b, false); }
+}
+
+void Multigrid::precondition(const std::vector<double>& r, std::vector<double>& z)
+{
+    Level& fine { m_levels.front() };
+    fine.b = r;
+    std::fill(fine.x.begin(), fine.x.end(), 0.0);
+    cycle(0);
+    z = fine.x;
+}
+
+int Multigrid::solve(const double* b, double* x)
+{
+    const Level& fine { m_levels.front() };
+    for (int X = 0; X < fine.nx; ++X)
+    {
+        for (int Y = 0; Y < fine.ny; ++Y)
+        {
+            const std::size_t k { static_cast<std::size_t>(fine.index(X, Y)) };
+            const bool active { fine.invDiag[k] > 0.0 };
+            m_b[k] = active ? b[X * fine.ny + Y] : 0.0;
+            m_x[k] = active ? x[X * fine.ny + Y] : 0.0;
+        }
+    }
+
+    // conjugate gradients from the given guess, preconditioned by one V-cycle. The error is measured in the
+    // energy norm (r^T M r with the V-cycle M): the dissipation sum Q^2 / D is the energy of the pressures, and
+    // a residual norm would not see errors behind edges at the conductance floor, which carry almost no
+    // current but still enter the dissipation.
+    apply(fine, m_x, m_q);
+    for (std::size_t k = 0; k < m_r.size(); ++k) { m_r[k] = m_b[k] - m_q[k]; }
+
+    m_iterations = -1;
+    double rz { 0.0 };
+    for (int it = 0; it <= m_max_iter; ++it)
+    {
+        precondition(m_r, m_z);
+        const double rzNew { dot(m_r, m_z) };
+        if (rzNew <= m_tol * m_tol * std::abs(dot(m_b, m_x)) || rzNew == 0.0)
+        {
+            m_iterations = it;
+            break;
+        }
+
+        if (it == 0) { m_p = m_z; }
+        else
+        {
+            const double beta { rzNew / rz };
+            for (std::size_t k = 0; k < m_p.size(); ++k) { m_p[k] = m_z[k] + beta * m_p[k]; }
+        }
+        rz = rzNew;
+
+        apply(fine, m_p, m_q);
+        const double alpha { rz / dot(m_p, m_q) };
+        for (std::size_t k = 0; k < m_x.size(); ++k)
+        {
+            m_x[k] += alpha * m_p[k];
+            m_r[k] -= alpha * m_q[k];
+        }
+    }
+
+    for (int X = 0; X < fine.nx; ++X)
+    {
+        for (int Y = 0; Y < fine.ny; ++Y) { x[X * fine.ny + Y] = m_x[static_cast<std::size_t>(fine.index(X, Y))]; }
+    }
+    return m_iterations;
+}
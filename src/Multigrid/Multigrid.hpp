@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "../EdgeKernel/EdgeKernel.hpp"
+
+// Pressure solve on the square lattice of `Graph::regularLattice` (node x * ny + y, links to x + 1 and y + 1)
+// without a sparse factorization: conjugate gradients preconditioned by one multigrid V-cycle.
+//
+// Every level stores its operator as a graph Laplacian on a grid, one conductance per link to the east, north,
+// north-east and north-west neighbour (the lattice itself is a 5-point stencil, the Galerkin coarse operators
+// are 9-point stencils). Interpolation is operator-dependent (Dendy's black box multigrid): a fine point takes
+// its coarse neighbours' values weighted by the conductances towards them, so channels of high conductance
+// next to edges at the floor are followed rather than averaged across, and the smoother relaxes whole grid lines
+// so channels along lines without coarse points converge as well. Coarse points are the points with the
+// parity of the grounded node, so it stays a coarse point on every level and the Galerkin product of the
+// full Laplacian is exactly the coarse operator of the grounded (reduced) system.
+// Every elimination (line solves, the coarsest level) forms its pivots as sums of conductances, never as
+// differences, since pivots of pieces hanging off the network by edges at the floor would otherwise be rounding
+// noise and the V-cycle would stop being positive definite.
+// Setup and every cycle are linear in the number of nodes; the coarsest level (a few dozen nodes) is factorized directly.
+class Multigrid
+{
+private:
+    struct Level
+    {
+        int nx { 0 }, ny { 0 };
+        int sx { 0 }; // stride of x in the padded arrays (a ghost layer of zero conductance surrounds the grid)
+        int ground { -1 }; // padded index of the node held at zero pressure
+        bool ninePoint { false };
+        std::vector<double> cE {}, cN {}, cNE {}, cNW {}; // link conductances
+        std::vector<double> diag {}, invDiag {}; // `invDiag` is 0 on the grounded node and on nodes without links
+        // factors of the line relaxation, [0] for lines along y, [1] along x: link to the previous node on the
+        // line, upper factor and inverse pivot (0 on held nodes)
+        std::array<std::vector<double>, 2> lineLower {}, lineUpper {}, lineInv {};
+
+        // interpolation from the next coarser level: coarse points sit at x = 2 X + ox, y = 2 Y + oy,
+        // every point takes four weights for the corners of the coarse cell it lies in
+        int ox { 0 }, oy { 0 };
+        std::vector<std::array<double, 4>> P {};
+
+        std::vector<double> x {}, b {}, r {}; // cycle vectors
+
+        int index(int X, int Y) const { return (X + 1) * sx + (Y + 1); }
+        double conductance(int k, int dx, int dy) const;
+    };
+
+    std::vector<Level> m_levels;
+    // dense factorization of the coarsest level: padded node of each row (active nodes only) and back
+    std::vector<int> m_coarse_node, m_coarse_row;
+    std::vector<double> m_coarse_L, m_coarse_pivot, m_coarse_y; // multipliers (strictly lower part), 1 / D
+
+    std::vector<double> m_b, m_x, m_r, m_z, m_p, m_q; // conjugate gradients on the finest level (padded)
+    std::vector<double> m_line_d; // line solves (padded, sized for the finest level)
+
+    double m_tol { 1e-10 }; // relative error of the pressures in the energy norm
+    int m_max_iter { 200 };
+    int m_iterations { 0 }; // of the last solve
+    int m_smoothing { 1 }; // line relaxation sweeps before and after the coarse correction
+
+    void shape(Level& level, int nx, int ny, bool ninePoint) const;
+    void interpolation(Level& fine, const Level& coarse);
+    void galerkin(const Level& fine, Level& coarse);
+    void finish(Level& level) const;
+    void factorLines(Level& level) const;
+    void factorCoarsest();
+
+    void apply(const Level& level, const std::vector<double>& x, std::vector<double>& y) const;
+    void relaxLines(const Level& level, std::vector<double>& x, const std::vector<double>& b, bool alongY, int parity);
+    void smooth(const Level& level, std::vector<double>& x, const std::vector<double>& b, bool forward);
+    void cycle(std::size_t l);
+    void precondition(const std::vector<double>& r, std::vector<double>& z);
+
+public:
+    // operator of the lattice from the conductances of the listed edges (edge `a` has conductance
+    // `D[edges.edge[a]]`, or `D[a]` without an index), with `ground` held at zero pressure
+    void setup(int nx, int ny, const EdgeKernel::Endpoints& edges, const double* D, int ground);
+    // solves for the pressures of every node (unpadded, `b` at the grounded node is ignored) starting from `x`;
+    // returns the number of iterations, or -1 if the tolerance was not reached
+    int solve(const double* b, double* x);
+
+    void setTolerance(double tol, int maxIter = 200) { m_tol = tol; m_max_iter = maxIter; }
+    double tolerance() const { return m_tol; }
+    int iterations() const { return m_iterations; }
+    std::size_t levels() const { return m_levels.size(); }
+};
@@ -0,0 +1,260 @@
+#include "Raster.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    void fail(const std::string& what)
+    {
+        throw std::ios_base::failure(what + ": " + std::strerror(errno));
+    }
+
+    void writeAll(std::FILE* file, const std::vector<uint8_t>& bytes, const std::string& what)
+    {
+        if (std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size()) { fail("Failed to write " + what); }
+    }
+
+    // pixels [first, last) of an interval [lo, hi] in pixel coordinates, clipped to [begin, end)
+    void pixelRange(float lo, float hi, std::size_t begin, std::size_t end, std::size_t& first, std::size_t& last)
+    {
+        const float b { static_cast<float>(begin) }, e { static_cast<float>(end) };
+        first = static_cast<std::size_t>(std::clamp(std::floor(lo), b, e));
+        last = static_cast<std::size_t>(std::clamp(std::ceil(hi), b, e));
+    }
+
+    // `src` over `dst` with alpha `a`
+    void blend(float* dst, const float* src, float a)
+    {
+        for (int c = 0; c < 3; ++c) { dst[c] += a * (src[c] - dst[c]); }
+    }
+}
+
+GraphRasterizer::GraphRasterizer(const Graph& graph, float sceneWidth, float sceneHeight, const RasterOptions& options)
+: m_options { options }
+, m_halfWidth { 0.5f * (options.lineWidth > 0.0f ? options.lineWidth : std::max(1.0f, static_cast<float>(options.height) / 768.0f)) }
+, m_segments {}
+, m_discs {}
+, m_tilesX { (options.width + options.tileSize - 1) / std::max(options.tileSize, 1u) }
+, m_tilesY { (options.height + options.tileSize - 1) / std::max(options.tileSize, 1u) }
+, m_tileSegments(m_tilesX * m_tilesY)
+, m_tileDiscs(m_tilesX * m_tilesY)
+, m_frame(3 * static_cast<std::size_t>(options.width) * options.height, 0)
+{
+    if (options.width == 0 || options.height == 0 || options.tileSize == 0)
+    {
+        throw std::invalid_argument("GraphRasterizer needs a frame and tiles of at least one pixel");
+    }
+
+    // scene to pixels: uniform scale, centered, y flipped (rows run top to bottom)
+    const float W { static_cast<float>(options.width) }, H { static_cast<float>(options.height) };
+    const float scale { std::min(W / sceneWidth, H / sceneHeight) };
+    const float ox { 0.5f * (W - scale * sceneWidth) }, oy { 0.5f * (H - scale * sceneHeight) };
+    auto toPixels = [&](const glm::fvec2& p) { return glm::fvec2(ox + scale * p.x, oy + scale * (sceneHeight - p.y)); };
+
+    const std::vector<Node>& nodes { graph.nodes() };
+    for (const Edge& edge : graph.edges())
+    {
+        const glm::fvec2 a { toPixels(nodes[edge.i].pos) }, b { toPixels(nodes[edge.j].pos) };
+        m_segments.push_back(Segment{ a.x, a.y, b.x, b.y });
+    }
+
+    // same size and colors as the window's circles (`colorNode` in main.cpp)
+    const Eigen::VectorXd& s { graph.getS() };
+    const float radius { 0.2f * std::sqrt(sceneWidth * sceneHeight / static_cast<float>(graph.nodeCount())) * scale };
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        const double si { s(static_cast<Eigen::Index>(i)) };
+        if (si == 0.0) { continue; }
+        const float alpha { std::min(1.0f, static_cast<float>(std::sqrt(std::abs(si)))) };
+        const glm::fvec2 p { toPixels(nodes[i].pos) };
+        m_discs.push_back(si > 0.0 ? Disc{ p.x, p.y, radius, { 0.0f, 1.0f, 1.0f, alpha } } : Disc{ p.x, p.y, radius, { 1.0f, 0.0f, 0.0f, alpha } });
+    }
+
+    // bin every primitive into the tiles its bounding box (plus the antialiasing fringe) touches
+    const float tile { static_cast<float>(options.tileSize) };
+    auto bin = [&](std::vector<std::vector<uint32_t>>& tiles, uint32_t k, float x0, float y0, float x1, float y1)
+    {
+        std::size_t tx0, tx1, ty0, ty1;
+        pixelRange(x0 / tile, x1 / tile, 0, m_tilesX, tx0, tx1);
+        pixelRange(y0 / tile, y1 / tile, 0, m_tilesY, ty0, ty1);
+        for (std::size_t ty = ty0; ty < ty1; ++ty)
+        {
+            for (std::size_t tx = tx0; tx < tx1; ++tx) { tiles[ty * m_tilesX + tx].push_back(k); }
+        }
+    };
+    const float fringe { m_halfWidth + 1.0f };
+    for (uint32_t k = 0; k < m_segments.size(); ++k)
+    {
+        const Segment& l { m_segments[k] };
+        bin(m_tileSegments, k, std::min(l.x0, l.x1) - fringe, std::min(l.y0, l.y1) - fringe, std::max(l.x0, l.x1) + fringe, std::max(l.y0, l.y1) + fringe);
+    }
+    for (uint32_t k = 0; k < m_discs.size(); ++k)
+    {
+        const Disc& d { m_discs[k] };
+        bin(m_tileDiscs, k, d.x - d.radius - 1.0f, d.y - d.radius - 1.0f, d.x + d.radius + 1.0f, d.y + d.radius + 1.0f);
+    }
+}
+
+void GraphRasterizer::drawTile(std::size_t tile, const Eigen::VectorXd& D, const Eigen::VectorXd& Q, std::vector<float>& rgb)
+{
+    const std::size_t size { m_options.tileSize };
+    const std::size_t px0 { (tile % m_tilesX) * size }, py0 { (tile / m_tilesX) * size };
+    const std::size_t px1 { std::min<std::size_t>(px0 + size, m_options.width) }, py1 { std::min<std::size_t>(py0 + size, m_options.height) };
+    std::fill(rgb.begin(), rgb.end(), 0.0f);
+
+    // coverage of a pixel whose center lies `distance` from a shape's edge (inside when negative), one pixel of ramp
+    auto coverage = [](float distance) { return std::clamp(0.5f - distance, 0.0f, 1.0f); };
+
+    for (uint32_t k : m_tileSegments[tile])
+    {
+        const Eigen::Index e { static_cast<Eigen::Index>(k) };
+        const float alpha { std::min(1.0f, static_cast<float>(5.0 * std::sqrt(std::abs(D(e))))) };
+        if (alpha < 1.0f / 512.0f) { continue; } // would not change a byte
+        const float color[3] { 1.0f, 1.0f, std::clamp(1.0f - static_cast<float>(10.0 * std::abs(Q(e))), 0.0f, 1.0f) };
+
+        const Segment& l { m_segments[k] };
+        const float dx { l.x1 - l.x0 }, dy { l.y1 - l.y0 };
+        const float invLength2 { dx * dx + dy * dy > 0.0f ? 1.0f / (dx * dx + dy * dy) : 0.0f };
+        std::size_t x0, x1, y0, y1;
+        pixelRange(std::min(l.x0, l.x1) - m_halfWidth - 0.5f, std::max(l.x0, l.x1) + m_halfWidth + 0.5f, px0, px1, x0, x1);
+        pixelRange(std::min(l.y0, l.y1) - m_halfWidth - 0.5f, std::max(l.y0, l.y1) + m_halfWidth + 0.5f, py0, py1, y0, y1);
+        for (std::size_t y = y0; y < y1; ++y)
+        {
+            const float cy { static_cast<float>(y) + 0.5f - l.y0 };
+            for (std::size_t x = x0; x < x1; ++x)
+            {
+                // distance from the pixel center to the segment
+                const float cx { static_cast<float>(x) + 0.5f - l.x0 };
+                const float t { std::clamp((cx * dx + cy * dy) * invLength2, 0.0f, 1.0f) };
+                const float ex { cx - t * dx }, ey { cy - t * dy };
+                const float a { alpha * coverage(std::sqrt(ex * ex + ey * ey) - m_halfWidth) };
+                if (a > 0.0f) { blend(&rgb[3 * ((y - py0) * size + (x - px0))], color, a); }
+            }
+        }
+    }
+
+    for (uint32_t k : m_tileDiscs[tile])
+    {
+        const Disc& d { m_discs[k] };
+        std::size_t x0, x1, y0, y1;
+        pixelRange(d.x - d.radius - 0.5f, d.x + d.radius + 0.5f, px0, px1, x0, x1);
+        pixelRange(d.y - d.radius - 0.5f, d.y + d.radius + 0.5f, py0, py1, y0, y1);
+        for (std::size_t y = y0; y < y1; ++y)
+        {
+            const float cy { static_cast<float>(y) + 0.5f - d.y };
+            for (std::size_t x = x0; x < x1; ++x)
+            {
+                const float cx { static_cast<float>(x) + 0.5f - d.x };
+                const float a { d.color[3] * coverage(std::sqrt(cx * cx + cy * cy) - d.radius) };
+                if (a > 0.0f) { blend(&rgb[3 * ((y - py0) * size + (x - px0))], d.color, a); }
+            }
+        }
+    }
+
+    for (std::size_t y = py0; y < py1; ++y)
+    {
+        uint8_t* row { &m_frame[3 * (y * m_options.width + px0)] };
+        const float* src { &rgb[3 * (y - py0) * size] };
+        for (std::size_t c = 0; c < 3 * (px1 - px0); ++c) { row[c] = static_cast<uint8_t>(255.0f * src[c] + 0.5f); }
+    }
+}
+
+const std::vector<uint8_t>& GraphRasterizer::draw(const Eigen::VectorXd& D, const Eigen::VectorXd& Q)
+{
+    if (static_cast<std::size_t>(D.size()) != m_segments.size() || static_cast<std::size_t>(Q.size()) != m_segments.size())
+    {
+        throw std::invalid_argument("GraphRasterizer::draw: D and Q need one value per edge");
+    }
+
+    // threads pull tiles until none are left
+    const std::size_t nTiles { m_tilesX * m_tilesY };
+    const unsigned int hardware { std::max(1u, std::thread::hardware_concurrency()) };
+    const std::size_t nThreads { std::min<std::size_t>(m_options.threads > 0 ? m_options.threads : hardware, nTiles) };
+    std::atomic<std::size_t> next { 0 };
+    auto work = [&]()
+    {
+        std::vector<float> rgb(3 * static_cast<std::size_t>(m_options.tileSize) * m_options.tileSize);
+        for (std::size_t tile = next++; tile < nTiles; tile = next++) { drawTile(tile, D, Q, rgb); }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads - 1);
+    for (std::size_t t = 1; t < nThreads; ++t) { threads.emplace_back(work); }
+    work();
+    for (std::thread& thread : threads) { thread.join(); }
+    return m_frame;
+}
+
+FrameSink::FrameSink(const std::string& target, unsigned int width, unsigned int height)
+: m_target { target }
+, m_width { width }
+, m_height { height }
+{
+    if (target == "-")
+    {
+        m_stdout = true;
+    }
+    else if (!target.empty() && target.front() == '|')
+    {
+        m_pipe = ::popen(target.c_str() + 1, "w");
+        if (!m_pipe) { fail("Failed to start " + target.substr(1)); }
+    }
+    else
+    {
+        const std::filesystem::path parent { std::filesystem::path(target).parent_path() };
+        if (!parent.empty()) { std::filesystem::create_directories(parent); }
+    }
+}
+
+FrameSink::~FrameSink()
+{
+    if (m_pipe) { ::pclose(m_pipe); }
+}
+
+void FrameSink::write(const std::vector<uint8_t>& frame)
+{
+    if (frame.size() != 3 * static_cast<std::size_t>(m_width) * m_height)
+    {
+        throw std::invalid_argument("FrameSink::write: the frame is not " + std::to_string(m_width) + 'x' + std::to_string(m_height) + " RGB24");
+    }
+
+    if (m_stdout)
+    {
+        writeAll(stdout, frame, "stdout");
+    }
+    else if (m_pipe)
+    {
+        writeAll(m_pipe, frame, m_target.substr(1));
+    }
+    else
+    {
+        char index[16];
+        std::snprintf(index, sizeof(index), "_%06zu.ppm", m_frames);
+        const std::string filename { m_target + index };
+        std::FILE* file { std::fopen(filename.c_str(), "wb") };
+        if (!file) { fail("Failed to open " + filename); }
+        const std::string header { "P6\n" + std::to_string(m_width) + ' ' + std::to_string(m_height) + "\n255\n" };
+        const bool written { std::fwrite(header.data(), 1, header.size(), file) == header.size()
+            && std::fwrite(frame.data(), 1, frame.size(), file) == frame.size() };
+        if (std::fclose(file) != 0 || !written) { fail("Failed to write " + filename); }
+    }
+    ++m_frames;
+}
+
+void FrameSink::close()
+{
+    if (m_stdout && std::fflush(stdout) != 0) { fail("Failed to flush stdout"); }
+    if (!m_pipe) { return; }
+
+    const int status { ::pclose(m_pipe) };
+    m_pipe = nullptr;
+    if (status != 0) { throw std::ios_base::failure(m_target.substr(1) + " exited with status " + std::to_string(status)); }
+}
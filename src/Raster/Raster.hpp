@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Dense>
+
+#include "../Graph/Graph.hpp"
+
+struct RasterOptions
+{
+    unsigned int width { 3840 }; // frame size in pixels
+    unsigned int height { 2160 };
+    unsigned int tileSize { 64 }; // pixels per side of the squares the threads draw independently
+    unsigned int threads { 0 }; // 0: one per hardware thread
+    float lineWidth { 0.0f }; // in pixels, 0: one pixel per 768 rows (the interactive window's lines, scaled)
+};
+
+// Draws a graph on the CPU the way the interactive window does, for movies rendered without a GPU or display:
+// edges white with the blue channel 1 - 10|Q| and alpha 5 sqrt(D), then sources (cyan) and sinks (red) as discs of
+// alpha sqrt|s|, blended over black in that order. The scene (the graph's width x height box) is scaled to fit the frame
+// and centered, y up. The frame is split into tiles, each drawn by one thread with every primitive overlapping it
+// (binned once, the layout never moves), so threads share no pixels and the result does not depend on their number.
+class GraphRasterizer
+{
+private:
+    struct Segment
+    {
+        float x0, y0, x1, y1;
+    };
+    struct Disc
+    {
+        float x, y, radius;
+        float color[4];
+    };
+
+    RasterOptions m_options;
+    float m_halfWidth; // of a line, in pixels
+    std::vector<Segment> m_segments; // per edge, in pixels
+    std::vector<Disc> m_discs;
+    std::size_t m_tilesX, m_tilesY;
+    std::vector<std::vector<uint32_t>> m_tileSegments; // per tile, the overlapping edges in drawing order
+    std::vector<std::vector<uint32_t>> m_tileDiscs;
+    std::vector<uint8_t> m_frame;
+
+    void drawTile(std::size_t tile, const Eigen::VectorXd& D, const Eigen::VectorXd& Q, std::vector<float>& rgb);
+
+public:
+    GraphRasterizer(const Graph& graph, float sceneWidth, float sceneHeight, const RasterOptions& options = RasterOptions{});
+
+    // the frame for conductances `D` and flows `Q` (in the graph's edge order): RGB24, rows top to bottom
+    const std::vector<uint8_t>& draw(const Eigen::VectorXd& D, const Eigen::VectorXd& Q);
+
+    unsigned int width() const { return m_options.width; }
+    unsigned int height() const { return m_options.height; }
+};
+
+// Where rendered frames go:
+//   "-"        : raw RGB24 frames to stdout
+//   "|command" : raw RGB24 frames piped into a shell command, e.g.
+//                "|ffmpeg -f rawvideo -pix_fmt rgb24 -s 3840x2160 -r 30 -i - -pix_fmt yuv420p movie.mp4"
+//   otherwise  : one binary PPM per frame, `<target>_000000.ppm`, `<target>_000001.ppm`, ...
+class FrameSink
+{
+private:
+    std::string m_target;
+    unsigned int m_width, m_height;
+    std::FILE* m_pipe { nullptr };
+    bool m_stdout { false };
+    std::size_t m_frames { 0 };
+
+public:
+    FrameSink(const std::string& target, unsigned int width, unsigned int height);
+    ~FrameSink();
+
+    FrameSink(const FrameSink&) = delete;
+    FrameSink& operator=(const FrameSink&) = delete;
+
+    void write(const std::vector<uint8_t>& frame);
+    // waits for a piped command to finish, throws if it failed
+    void close();
+
+    std::size_t frames() const { return m_frames; }
+};
@@ -0,0 +1,180 @@
+#include "Recorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ios>
+
+namespace
+{
+    constexpr char magic[9] { "TKNTRAJ1" };
+
+    enum FrameType : uint8_t { RawFrame = 0, KeyFrame = 1, DeltaFrame = 2 };
+
+    template <typename T>
+    void append(std::vector<char>& buffer, const T& value)
+    {
+        const char* bytes { reinterpret_cast<const char*>(&value) };
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename Int>
+    void appendDeltas(std::vector<char>& buffer, const std::vector<int32_t>& quant, const std::vector<int32_t>& prev)
+    {
+        for (std::size_t k = 0; k < quant.size(); ++k)
+        {
+            append(buffer, static_cast<Int>(quant[k] - prev[k]));
+        }
+    }
+}
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string& filename, std::size_t nEdges, const RecorderOptions& options)
+: m_options { options }
+, m_edges { nEdges }
+, m_file(filename + ".traj", std::ios::binary)
+, m_ring(std::max<std::size_t>(options.ringSize, 1))
+, m_mutex {}
+, m_cv_filled {}
+, m_cv_freed {}
+, m_prev(nEdges)
+, m_quant(nEdges)
+, m_buffer {}
+, m_writer {}
+{
+    if (!m_file.is_open()) {
+        throw std::ios_base::failure("Failed to open file!");
+    }
+    m_options.decimation = std::max(m_options.decimation, 1u);
+    m_options.keyframeInterval = std::max(m_options.keyframeInterval, 1u);
+
+    for (Snapshot& snapshot : m_ring)
+    {
+        snapshot.D.resize(nEdges);
+    }
+    m_buffer.reserve(16 + nEdges * sizeof(double));
+
+    std::vector<char> header;
+    header.insert(header.end(), magic, magic + 8);
+    append(header, uint32_t { 1 });
+    append(header, static_cast<uint32_t>(m_options.encoding));
+    append(header, static_cast<uint64_t>(nEdges));
+    append(header, static_cast<uint32_t>(m_options.decimation));
+    append(header, static_cast<uint32_t>(m_options.keyframeInterval));
+    append(header, m_options.quantum);
+    m_file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    m_bytes += header.size();
+
+    m_writer = std::thread(&TrajectoryRecorder::writerLoop, this);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    close();
+}
+
+void TrajectoryRecorder::record(std::size_t step, const Eigen::VectorXd& D)
+{
+    if (step % m_options.decimation != 0) { return; }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv_freed.wait(lock, [&]{ return m_count < m_ring.size() || m_closing; });
+    if (m_closing) { return; }
+
+    // the slot is not visible to the writer until `m_count` is bumped, so copy without the lock
+    Snapshot& slot { m_ring[m_head] };
+    lock.unlock();
+    slot.step = step;
+    std::copy(D.data(), D.data() + std::min<std::size_t>(m_edges, static_cast<std::size_t>(D.size())), slot.D.begin());
+    lock.lock();
+
+    m_head = (m_head + 1) % m_ring.size();
+    ++m_count;
+    m_cv_filled.notify_one();
+}
+
+void TrajectoryRecorder::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closing) { return; }
+        m_closing = true;
+    }
+    m_cv_filled.notify_all();
+    m_cv_freed.notify_all();
+
+    if (m_writer.joinable()) { m_writer.join(); }
+    m_file.close();
+}
+
+void TrajectoryRecorder::writerLoop()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv_filled.wait(lock, [&]{ return m_count > 0 || m_closing; });
+        if (m_count == 0) { return; } // closing and drained
+
+        Snapshot& slot { m_ring[m_tail] };
+        lock.unlock();
+        writeFrame(slot);
+        lock.lock();
+
+        m_tail = (m_tail + 1) % m_ring.size();
+        --m_count;
+        m_cv_freed.notify_one();
+    }
+}
+
+void TrajectoryRecorder::writeFrame(const Snapshot& snapshot)
+{
+    m_buffer.clear();
+
+    uint8_t type { RawFrame };
+    uint8_t width { sizeof(double) };
+
+    if (m_options.encoding == TrajectoryEncoding::Raw)
+    {
+        m_buffer.resize(16);
+        const char* bytes { reinterpret_cast<const char*>(snapshot.D.data()) };
+        m_buffer.insert(m_buffer.end(), bytes, bytes + m_edges * sizeof(double));
+    }
+    else
+    {
+        const double scale { 1.0 / m_options.quantum };
+        int32_t maxDelta { 0 };
+        for (std::size_t k = 0; k < m_edges; ++k)
+        {
+            m_quant[k] = static_cast<int32_t>(std::lround(std::log10(snapshot.D[k]) * scale));
+            maxDelta = std::max(maxDelta, std::abs(m_quant[k] - m_prev[k]));
+        }
+
+        m_buffer.resize(16);
+        if (m_frames % m_options.keyframeInterval == 0)
+        {
+            type = KeyFrame;
+            width = sizeof(int32_t);
+            const char* bytes { reinterpret_cast<const char*>(m_quant.data()) };
+            m_buffer.insert(m_buffer.end(), bytes, bytes + m_edges * sizeof(int32_t));
+        }
+        else
+        {
+            // narrowest integer that holds every delta of this frame
+            type = DeltaFrame;
+            if (maxDelta <= INT8_MAX)       { width = 1; appendDeltas<int8_t>(m_buffer, m_quant, m_prev); }
+            else if (maxDelta <= INT16_MAX) { width = 2; appendDeltas<int16_t>(m_buffer, m_quant, m_prev); }
+            else                            { width = 4; appendDeltas<int32_t>(m_buffer, m_quant, m_prev); }
+        }
+        std::swap(m_prev, m_quant);
+    }
+
+    // frame header
+    uint64_t step { snapshot.step };
+    std::memset(m_buffer.data(), 0, 16);
+    std::memcpy(m_buffer.data(), &type, 1);
+    std::memcpy(m_buffer.data() + 1, &width, 1);
+    std::memcpy(m_buffer.data() + 8, &step, 8);
+
+    m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_bytes += m_buffer.size();
+    ++m_frames;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Dense>
+
+enum class TrajectoryEncoding : uint32_t
+{
+    Raw = 0,           // float64 conductances
+    DeltaQuantized = 1 // log10(D) quantized to integers, delta-coded against the previous frame
+};
+
+struct RecorderOptions
+{
+    unsigned int decimation { 1 }; // keep every n-th step
+    TrajectoryEncoding encoding { TrajectoryEncoding::DeltaQuantized };
+    double quantum { 1e-4 }; // log10(D) resolution (~0.01% relative error in D)
+    unsigned int keyframeInterval { 100 }; // frames between absolute frames
+    std::size_t ringSize { 32 }; // snapshots in flight before `record` blocks
+};
+
+// Records conductance trajectories without stalling the simulation: `record` copies a snapshot into a
+// preallocated ring and a background thread encodes and writes it.
+//
+// File layout (native-endian, read by `load_trajectory` in trajectory.py):
+//   header : "TKNTRAJ1", uint32 version, uint32 encoding, uint64 nEdges, uint32 decimation,
+//            uint32 keyframeInterval, float64 quantum                                     (40 bytes)
+//   frame  : uint8 type (0 raw, 1 keyframe, 2 delta), uint8 bytes per value, uint16 + uint32 reserved,
+//            uint64 step, then nEdges values (float64 raw, int32 keyframe, int8/16/32 delta)
+class TrajectoryRecorder
+{
+private:
+    struct Snapshot
+    {
+        std::size_t step { 0 };
+        std::vector<double> D {};
+    };
+
+    RecorderOptions m_options;
+    std::size_t m_edges;
+    std::ofstream m_file;
+
+    // bounded ring shared with the writer thread
+    std::vector<Snapshot> m_ring;
+    std::size_t m_head { 0 }; // next slot to fill
+    std::size_t m_tail { 0 }; // next slot to write
+    std::size_t m_count { 0 };
+    bool m_closing { false };
+    std::mutex m_mutex;
+    std::condition_variable m_cv_filled;
+    std::condition_variable m_cv_freed;
+
+    // writer-side encoding state
+    std::vector<int32_t> m_prev, m_quant;
+    std::vector<char> m_buffer;
+    std::size_t m_frames { 0 };
+    std::size_t m_bytes { 0 };
+
+    std::thread m_writer;
+
+    void writerLoop();
+    void writeFrame(const Snapshot& snapshot);
+
+public:
+    TrajectoryRecorder(const std::string& filename, std::size_t nEdges, const RecorderOptions& options = RecorderOptions{});
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    // snapshot `D` if `step` is kept by the decimation (blocks only if the ring is full)
+    void record(std::size_t step, const Eigen::VectorXd& D);
+    // flush every pending snapshot and close the file
+    void close();
+
+    std::size_t frames() const { return m_frames; }
+    std::size_t bytesWritten() const { return m_bytes; }
+};
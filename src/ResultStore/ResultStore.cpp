@@ -0,0 +1,131 @@
+#include "ResultStore.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char metaMagic[9] { "TKNMETA2" }; // 2: growth law and cost exponent recorded
+    constexpr char valuesMagic[9] { "TKNVALS1" };
+    constexpr off_t headerSize { 16 }; // magic + uint32 version + uint32 element size
+
+    void fail(const std::string& what)
+    {
+        throw std::ios_base::failure(what + ": " + std::strerror(errno));
+    }
+
+    void writeAll(int fd, const void* data, std::size_t size)
+    {
+        const char* bytes { static_cast<const char*>(data) };
+        while (size > 0)
+        {
+            ssize_t n { ::write(fd, bytes, size) };
+            if (n < 0)
+            {
+                if (errno == EINTR) { continue; }
+                fail("ResultStore write failed");
+            }
+            bytes += n;
+            size -= static_cast<std::size_t>(n);
+        }
+    }
+
+    // releases the cross-process lock on scope exit
+    struct FileLock
+    {
+        int fd;
+        explicit FileLock(int file) : fd { file }
+        {
+            while (::flock(fd, LOCK_EX) != 0)
+            {
+                if (errno != EINTR) { fail("ResultStore lock failed"); }
+            }
+        }
+        ~FileLock() { ::flock(fd, LOCK_UN); }
+        FileLock(const FileLock&) = delete;
+        FileLock& operator=(const FileLock&) = delete;
+    };
+}
+
+off_t ResultStore::alignedEnd(int fd, std::size_t elementSize)
+{
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) { fail("ResultStore stat failed"); }
+
+    off_t end { st.st_size - (st.st_size - headerSize) % static_cast<off_t>(elementSize) };
+    if (end != st.st_size && ::ftruncate(fd, end) != 0) { fail("ResultStore truncate failed"); }
+    return end;
+}
+
+ResultStore::ResultStore(const std::string& directory)
+: m_directory { directory }
+, m_mutex {}
+{
+    std::filesystem::create_directories(m_directory);
+    m_meta_fd = openWithHeader(m_directory + "/meta.bin", metaMagic, sizeof(ResultRecord));
+    m_values_fd = openWithHeader(m_directory + "/values.bin", valuesMagic, sizeof(double));
+}
+
+ResultStore::~ResultStore()
+{
+    if (m_meta_fd >= 0) { ::close(m_meta_fd); }
+    if (m_values_fd >= 0) { ::close(m_values_fd); }
+}
+
+int ResultStore::openWithHeader(const std::string& filename, const char (&magic)[9], uint32_t elementSize)
+{
+    int fd { ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644) };
+    if (fd < 0) { fail("Failed to open " + filename); }
+
+    FileLock lock(fd);
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) { fail("Failed to stat " + filename); }
+
+    if (st.st_size == 0)
+    {
+        // fresh file: write the header (another process may have raced us, hence the lock)
+        char header[headerSize] {};
+        std::memcpy(header, magic, 8);
+        uint32_t version { static_cast<uint32_t>(magic[7] - '0') }; // the magic ends in the format version
+        std::memcpy(header + 8, &version, 4);
+        std::memcpy(header + 12, &elementSize, 4);
+        writeAll(fd, header, sizeof(header));
+    }
+    else
+    {
+        char header[8] {};
+        if (::pread(fd, header, 8, 0) != 8 || std::memcmp(header, magic, 8) != 0)
+        {
+            ::close(fd);
+            throw std::ios_base::failure(filename + " is not a result store file");
+        }
+    }
+
+    return fd;
+}
+
+void ResultStore::append(ResultRecord record, const std::vector<double>& values)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    FileLock lock(m_meta_fd);
+
+    // drop whatever a crashed writer left half-written, then append (O_APPEND) values before their record
+    off_t valuesEnd { alignedEnd(m_values_fd, sizeof(double)) };
+    alignedEnd(m_meta_fd, sizeof(ResultRecord));
+
+    record.offset = static_cast<uint64_t>(valuesEnd - headerSize) / sizeof(double);
+    record.count = values.size();
+
+    writeAll(m_values_fd, values.data(), values.size() * sizeof(double));
+    if (::fsync(m_values_fd) != 0) { fail("Failed to sync values.bin"); }
+
+    writeAll(m_meta_fd, &record, sizeof(record));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+// what the values of a record hold
+enum class ResultKind : uint32_t
+{
+    RayleighQuotients = 0, // `Graph::sampleHSpec` output
+    LanczosQuadrature = 1  // (node, weight) pairs of `Graph::spectralDensity`, probes concatenated
+};
+
+// fixed-size metadata row of `meta.bin` (layout mirrored by `resultstore.py`, keep both in sync)
+struct ResultRecord
+{
+    uint64_t id { 0 }; // task id
+    uint64_t offset { 0 }; // index of the first value in `values.bin`
+    uint64_t count { 0 }; // number of values
+    uint64_t steps { 0 }; // time steps to convergence
+    uint32_t seed { 0 };
+    uint32_t resolution { 0 }; // nodes per side
+    uint32_t kind { 0 }; // `ResultKind`
+    uint32_t nSources { 0 };
+    uint32_t law { 0 }; // `EdgeKernel::GrowthLaw`
+    uint32_t reserved { 0 };
+    double dt { 0.0 };
+    double eps { 0.0 };
+    double D0 { 0.0 };
+    double tol { 0.0 };
+    double D_min { 0.0 };
+    double c_t { 0.0 };
+    double alpha { 0.0 };
+    double beta { 0.0 };
+    double gamma { 0.0 };
+    double costExponent { 0.0 };
+};
+static_assert(sizeof(ResultRecord) == 136, "ResultRecord layout is part of the file format");
+
+// Append-only columnar store of ensemble results in a directory:
+//   meta.bin   : 16-byte header, then one `ResultRecord` per graph
+//   values.bin : 16-byte header, then every record's float64 values back to back
+// Values are written before their record, so a record never points past the end of `values.bin`.
+// Appends are serialized by a mutex within a process and by `flock` across processes.
+// Both files are native-endian and can be memory-mapped from Python (see `resultstore.py`).
+class ResultStore
+{
+private:
+    std::string m_directory;
+    int m_meta_fd { -1 };
+    int m_values_fd { -1 };
+    std::mutex m_mutex;
+
+    // end of the last complete element, truncating a torn trailing write
+    static off_t alignedEnd(int fd, std::size_t elementSize);
+    static int openWithHeader(const std::string& filename, const char (&magic)[9], uint32_t elementSize);
+
+public:
+    explicit ResultStore(const std::string& directory);
+    ~ResultStore();
+
+    ResultStore(const ResultStore&) = delete;
+    ResultStore& operator=(const ResultStore&) = delete;
+
+    // fills `record.offset` and `record.count`
+    void append(ResultRecord record, const std::vector<double>& values);
+
+    const std::string& directory() const { return m_directory; }
+};
@@ -0,0 +1,201 @@
+#include "Scheduler.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+
+Scheduler::Scheduler(std::size_t nWorkers, Job job)
+: m_job { std::move(job) }
+, m_workers {}
+, m_threads {}
+, m_mutex {}
+, m_cv_work {}
+, m_cv_done {}
+, m_report_mutex {}
+, m_task_reports {}
+, m_window_start { Clock::now() }
+{
+    nWorkers = std::max<std::size_t>(nWorkers, 1);
+
+    m_workers.reserve(nWorkers);
+    for (std::size_t i = 0; i < nWorkers; ++i)
+    {
+        m_workers.emplace_back(std::make_unique<Worker>());
+    }
+
+    m_threads.reserve(nWorkers);
+    for (std::size_t i = 0; i < nWorkers; ++i)
+    {
+        m_threads.emplace_back(&Scheduler::workerLoop, this, i);
+    }
+}
+
+Scheduler::~Scheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv_work.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void Scheduler::submit(const Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.fetch_add(1) == 0) { m_window_start = Clock::now(); }
+
+        Worker& worker { *m_workers[m_next_worker] };
+        m_next_worker = (m_next_worker + 1) % m_workers.size();
+
+        std::lock_guard<std::mutex> queue_lock(worker.mutex);
+        worker.queue.push_back(task);
+        ++m_queued;
+    }
+    m_cv_work.notify_one();
+}
+
+void Scheduler::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv_done.wait(lock, [&]{ return m_pending.load() == 0; });
+    m_window += std::chrono::duration<double>(Clock::now() - m_window_start).count();
+}
+
+bool Scheduler::tryPop(std::size_t worker_ID, Task& task, bool& stolen)
+{
+    // own queue first (LIFO keeps the most recently queued work hot)
+    {
+        Worker& own { *m_workers[worker_ID] };
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.queue.empty())
+        {
+            task = own.queue.back();
+            own.queue.pop_back();
+            --m_queued;
+            stolen = false;
+            return true;
+        }
+    }
+
+    // steal the oldest task from the other workers
+    for (std::size_t k = 1; k < m_workers.size(); ++k)
+    {
+        Worker& victim { *m_workers[(worker_ID + k) % m_workers.size()] };
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.queue.empty())
+        {
+            task = victim.queue.front();
+            victim.queue.pop_front();
+            --m_queued;
+            stolen = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Scheduler::workerLoop(std::size_t worker_ID)
+{
+    Worker& self { *m_workers[worker_ID] };
+
+    while (true)
+    {
+        Task task {};
+        bool stolen { false };
+
+        if (!tryPop(worker_ID, task, stolen))
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv_work.wait(lock, [&]{ return m_stop || m_queued.load() > 0; });
+            if (m_stop && m_queued.load() == 0) { return; }
+            continue;
+        }
+
+        Clock::time_point start { Clock::now() };
+        try
+        {
+            m_job(worker_ID, task);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Task " << task.id << " (seed " << task.seed << ") failed: " << e.what() << std::endl;
+        }
+        double wallTime { std::chrono::duration<double>(Clock::now() - start).count() };
+
+        self.report.busyTime += wallTime;
+        ++self.report.tasks;
+        if (stolen) { ++self.report.steals; }
+
+        {
+            std::lock_guard<std::mutex> lock(m_report_mutex);
+            m_task_reports.push_back(TaskReport{ task.id, worker_ID, stolen, wallTime });
+        }
+
+        if (m_pending.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cv_done.notify_all();
+        }
+    }
+}
+
+std::vector<WorkerReport> Scheduler::workerReports() const
+{
+    // idle time is whatever part of the scheduling windows a worker did not spend running tasks
+    std::vector<WorkerReport> reports;
+    reports.reserve(m_workers.size());
+    for (const auto& worker : m_workers)
+    {
+        WorkerReport report { worker->report };
+        report.idleTime = std::max(0.0, m_window - report.busyTime);
+        reports.push_back(report);
+    }
+    return reports;
+}
+
+void Scheduler::printSummary(std::ostream& out) const
+{
+    std::vector<WorkerReport> reports { workerReports() };
+
+    double busy { 0.0 };
+    double idle { 0.0 };
+    out << '\n' << "###################################" << '\n';
+    out << "Scheduler summary (" << reports.size() << " workers, " << m_task_reports.size() << " tasks)" << '\n';
+    for (std::size_t i = 0; i < reports.size(); ++i)
+    {
+        const WorkerReport& r { reports[i] };
+        busy += r.busyTime;
+        idle += r.idleTime;
+        out << "Worker " << i << '\t' << "tasks " << r.tasks << '\t' << "steals " << r.steals
+            << '\t' << "busy " << std::fixed << std::setprecision(3) << r.busyTime << " s"
+            << '\t' << "idle " << r.idleTime << " s" << '\n';
+    }
+
+    double total { busy + idle };
+    out << "Wall time : " << m_window << " s" << '\n';
+    out << "Utilization : " << std::setprecision(1) << (total > 0.0 ? 100.0 * busy / total : 0.0) << " %" << '\n';
+    out << "###################################" << '\n';
+    out << std::defaultfloat;
+}
+
+void Scheduler::exportReport(const std::string& filename) const
+{
+    std::ofstream outFile(filename + ".txt");
+    if (!outFile.is_open()) {
+        throw std::ios_base::failure("Failed to open file!");
+    }
+
+    outFile << "id,worker,stolen,wall_time" << '\n';
+    for (const TaskReport& r : m_task_reports)
+    {
+        outFile << r.id << ',' << r.worker << ',' << r.stolen << ',' << r.wallTime << '\n';
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Task
+{
+    std::size_t id; // output index (replaces `thread_ID + 8 * iter`)
+    uint32_t seed;
+    unsigned int resolution; // half resolution, graph is built with 2 * resolution + 1 nodes per side
+    double dt;
+};
+
+struct TaskReport
+{
+    std::size_t id;
+    std::size_t worker;
+    bool stolen; // task was taken from another worker's queue
+    double wallTime; // seconds
+};
+
+struct WorkerReport
+{
+    std::size_t tasks { 0 };
+    std::size_t steals { 0 };
+    double busyTime { 0.0 }; // seconds spent running tasks
+    double idleTime { 0.0 }; // seconds spent waiting for/looking for work while the ensemble was unfinished
+};
+
+// Persistent pool of workers, each owning a deque of tasks.
+// Workers pop their own queue from the back and steal from the front of the others,
+// so no core sits idle while any task of the ensemble remains queued.
+class Scheduler
+{
+public:
+    using Job = std::function<void(std::size_t worker_ID, const Task& task)>;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> queue;
+        WorkerReport report;
+    };
+
+    Job m_job;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv_work;
+    std::condition_variable m_cv_done;
+    std::atomic<std::size_t> m_queued { 0 }; // tasks sitting in a queue
+    std::atomic<std::size_t> m_pending { 0 }; // tasks submitted but not finished
+    bool m_stop { false };
+    std::size_t m_next_worker { 0 }; // round-robin target for `submit`
+
+    std::mutex m_report_mutex;
+    std::vector<TaskReport> m_task_reports;
+    Clock::time_point m_window_start;
+    double m_window { 0.0 }; // wall time of the last `wait()` window
+
+    void workerLoop(std::size_t worker_ID);
+    bool tryPop(std::size_t worker_ID, Task& task, bool& stolen);
+
+public:
+    Scheduler(std::size_t nWorkers, Job job);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    void submit(const Task& task);
+    // blocks until every submitted task has finished
+    void wait();
+
+    std::size_t workerCount() const { return m_workers.size(); }
+    const std::vector<TaskReport>& taskReports() const { return m_task_reports; }
+    std::vector<WorkerReport> workerReports() const;
+
+    void printSummary(std::ostream& out) const;
+    void exportReport(const std::string& filename) const;
+};
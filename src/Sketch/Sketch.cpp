@@ -0,0 +1,292 @@
+#include "Sketch.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "../Utilities/Utilities.hpp"
+
+namespace
+{
+    // layout of a sketch file (mirrored by `sketch.py`, keep both in sync):
+    // header, then per partition a `PartitionHeader` and the positive and negative bins (uint64 each)
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t binsPerDecade;
+        int32_t minExp;
+        int32_t maxExp;
+        uint32_t partitions;
+        uint64_t reserved;
+    };
+    static_assert(sizeof(FileHeader) == 32, "FileHeader layout is part of the file format");
+
+    struct PartitionHeader
+    {
+        uint64_t zero;
+        uint64_t underflow[2]; // positive, negative
+        uint64_t overflow[2];
+        uint64_t reserved;
+        double min;
+        double max;
+    };
+    static_assert(sizeof(PartitionHeader) == 64, "PartitionHeader layout is part of the file format");
+
+    constexpr char magic[9] { "TKNSKCH1" };
+
+    void fail(const std::string& what)
+    {
+        throw std::ios_base::failure(what + ": " + std::strerror(errno));
+    }
+
+    template <typename T>
+    void append(std::string& bytes, const T* data, std::size_t count)
+    {
+        bytes.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+    }
+
+    template <typename T>
+    void extract(const std::string& bytes, std::size_t& offset, T* data, std::size_t count)
+    {
+        std::memcpy(data, bytes.data() + offset, count * sizeof(T));
+        offset += count * sizeof(T);
+    }
+}
+
+LogSketch::LogSketch(const SketchLayout& layout)
+: m_layout { layout }
+, m_positive(layout.bins(), 0)
+, m_negative(layout.bins(), 0)
+, m_min { std::numeric_limits<double>::infinity() }
+, m_max { -std::numeric_limits<double>::infinity() }
+{
+    if (layout.binsPerDecade == 0 || layout.maxExp <= layout.minExp)
+    {
+        throw std::invalid_argument("LogSketch needs at least one bin");
+    }
+}
+
+double LogSketch::center(std::size_t k) const
+{
+    return std::pow(10.0, m_layout.minExp + (static_cast<double>(k) + 0.5) / m_layout.binsPerDecade);
+}
+
+void LogSketch::add(double x)
+{
+    // NaN has no place in any bin
+    if (std::isnan(x)) { return; }
+
+    m_min = std::min(m_min, x);
+    m_max = std::max(m_max, x);
+    if (x == 0.0)
+    {
+        ++m_zero;
+        return;
+    }
+
+    const std::size_t sign { x > 0.0 ? 0u : 1u };
+    const double position { (std::log10(std::abs(x)) - m_layout.minExp) * m_layout.binsPerDecade };
+    if (position < 0.0)
+    {
+        ++m_underflow[sign];
+    }
+    else if (position >= static_cast<double>(m_layout.bins()))
+    {
+        ++m_overflow[sign];
+    }
+    else
+    {
+        std::vector<uint64_t>& bins { sign == 0 ? m_positive : m_negative };
+        ++bins[static_cast<std::size_t>(position)];
+    }
+}
+
+void LogSketch::merge(const LogSketch& other)
+{
+    if (!(m_layout == other.m_layout)) { throw std::invalid_argument("LogSketch::merge: the layouts differ"); }
+
+    for (std::size_t k = 0; k < m_positive.size(); ++k)
+    {
+        m_positive[k] += other.m_positive[k];
+        m_negative[k] += other.m_negative[k];
+    }
+    m_zero += other.m_zero;
+    for (std::size_t sign = 0; sign < 2; ++sign)
+    {
+        m_underflow[sign] += other.m_underflow[sign];
+        m_overflow[sign] += other.m_overflow[sign];
+    }
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t LogSketch::positives() const
+{
+    uint64_t n { m_underflow[0] + m_overflow[0] };
+    for (uint64_t c : m_positive) { n += c; }
+    return n;
+}
+
+uint64_t LogSketch::negatives() const
+{
+    uint64_t n { m_underflow[1] + m_overflow[1] };
+    for (uint64_t c : m_negative) { n += c; }
+    return n;
+}
+
+uint64_t LogSketch::count() const
+{
+    return positives() + negatives() + m_zero;
+}
+
+double LogSketch::quantile(double q, bool positiveOnly) const
+{
+    const uint64_t n { positiveOnly ? positives() : count() };
+    if (n == 0) { return std::numeric_limits<double>::quiet_NaN(); }
+
+    // 0-based rank of the nearest order statistic, then walk the bins in ascending order of value
+    const uint64_t rank { static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(n - 1) + 0.5) };
+    uint64_t below { 0 };
+    auto reaches = [&](uint64_t c) { below += c; return below > rank; };
+
+    const double smallest { std::pow(10.0, m_layout.minExp) };
+    if (!positiveOnly)
+    {
+        if (reaches(m_overflow[1])) { return m_min; }
+        for (std::size_t k = m_negative.size(); k-- > 0;)
+        {
+            if (reaches(m_negative[k])) { return -center(k); }
+        }
+        if (reaches(m_underflow[1])) { return -smallest; }
+        if (reaches(m_zero)) { return 0.0; }
+    }
+    if (reaches(m_underflow[0])) { return smallest; }
+    for (std::size_t k = 0; k < m_positive.size(); ++k)
+    {
+        if (reaches(m_positive[k])) { return center(k); }
+    }
+    return m_max;
+}
+
+void LogSketch::print(std::ostream& os) const
+{
+    const uint64_t n { count() };
+    os << "Rayleigh quotients : " << n << " sketched, " << (n > 0 ? 100.0 * static_cast<double>(negatives()) / static_cast<double>(n) : 0.0)
+       << "% negative" << '\n';
+    os << "positive quantiles : 50% " << quantile(0.5, true) << ", 90% " << quantile(0.9, true) << ", 99% " << quantile(0.99, true) << '\n';
+}
+
+SketchAggregator::SketchAggregator(const std::string& directory, std::size_t nWorkers, std::size_t partitions, const SketchLayout& layout)
+: m_directory { directory }
+, m_run { std::to_string(std::time(nullptr)) + '_' + std::to_string(::getpid()) }
+, m_layout { layout }
+, m_sketches(nWorkers, std::vector<LogSketch>(std::max<std::size_t>(partitions, 1), LogSketch(layout)))
+{
+    std::filesystem::create_directories(m_directory + "/parts");
+}
+
+void SketchAggregator::add(std::size_t worker_ID, std::size_t taskId, const std::vector<double>& values)
+{
+    std::vector<LogSketch>& sketches { m_sketches[worker_ID] };
+    sketches[taskId % sketches.size()].add(values);
+    save(m_directory + "/parts/" + m_run + '_' + std::to_string(worker_ID) + ".sketch", sketches);
+}
+
+void SketchAggregator::save(const std::string& filename, const std::vector<LogSketch>& sketches) const
+{
+    FileHeader header {};
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.binsPerDecade = m_layout.binsPerDecade;
+    header.minExp = m_layout.minExp;
+    header.maxExp = m_layout.maxExp;
+    header.partitions = static_cast<uint32_t>(sketches.size());
+
+    std::string bytes;
+    bytes.reserve(sizeof(FileHeader) + sketches.size() * (sizeof(PartitionHeader) + 2 * m_layout.bins() * sizeof(uint64_t)));
+    append(bytes, &header, 1);
+    for (const LogSketch& sketch : sketches)
+    {
+        PartitionHeader partition {};
+        partition.zero = sketch.m_zero;
+        partition.underflow[0] = sketch.m_underflow[0];
+        partition.underflow[1] = sketch.m_underflow[1];
+        partition.overflow[0] = sketch.m_overflow[0];
+        partition.overflow[1] = sketch.m_overflow[1];
+        partition.min = sketch.m_min;
+        partition.max = sketch.m_max;
+        append(bytes, &partition, 1);
+        append(bytes, sketch.m_positive.data(), sketch.m_positive.size());
+        append(bytes, sketch.m_negative.data(), sketch.m_negative.size());
+    }
+
+    // each file has a single writer, so the temporary name cannot collide
+    Utilities::replaceSynced(filename, bytes);
+}
+
+std::vector<LogSketch> SketchAggregator::load(const std::string& filename) const
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) { fail("Failed to open " + filename); }
+    const std::string bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    const std::size_t partitions { m_sketches.empty() ? 0 : m_sketches.front().size() };
+    const std::size_t expected { sizeof(FileHeader) + partitions * (sizeof(PartitionHeader) + 2 * m_layout.bins() * sizeof(uint64_t)) };
+    FileHeader header {};
+    if (bytes.size() >= sizeof(FileHeader)) { std::memcpy(&header, bytes.data(), sizeof(FileHeader)); }
+    if (bytes.size() != expected || std::memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.partitions != partitions
+        || !(SketchLayout{ header.binsPerDecade, header.minExp, header.maxExp } == m_layout))
+    {
+        throw std::ios_base::failure(filename + " is not a sketch file of this layout and partition count");
+    }
+
+    std::vector<LogSketch> sketches(partitions, LogSketch(m_layout));
+    std::size_t offset { sizeof(FileHeader) };
+    for (LogSketch& sketch : sketches)
+    {
+        PartitionHeader partition {};
+        extract(bytes, offset, &partition, 1);
+        sketch.m_zero = partition.zero;
+        sketch.m_underflow = { partition.underflow[0], partition.underflow[1] };
+        sketch.m_overflow = { partition.overflow[0], partition.overflow[1] };
+        sketch.m_min = partition.min;
+        sketch.m_max = partition.max;
+        extract(bytes, offset, sketch.m_positive.data(), sketch.m_positive.size());
+        extract(bytes, offset, sketch.m_negative.data(), sketch.m_negative.size());
+    }
+    return sketches;
+}
+
+std::vector<LogSketch> SketchAggregator::merged() const
+{
+    const std::size_t partitions { m_sketches.empty() ? 0 : m_sketches.front().size() };
+    std::vector<LogSketch> sketches(partitions, LogSketch(m_layout));
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory + "/parts"))
+    {
+        if (entry.path().extension() != ".sketch") { continue; }
+        const std::vector<LogSketch> part { load(entry.path().string()) };
+        for (std::size_t p = 0; p < partitions; ++p) { sketches[p].merge(part[p]); }
+    }
+    return sketches;
+}
+
+LogSketch SketchAggregator::writeAggregate() const
+{
+    const std::vector<LogSketch> sketches { merged() };
+    save(m_directory + "/aggregate.sketch", sketches);
+
+    LogSketch total(m_layout);
+    for (const LogSketch& sketch : sketches) { total.merge(sketch); }
+    return total;
+}
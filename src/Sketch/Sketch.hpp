@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// bins of a `LogSketch`: `binsPerDecade` per decade of |x| over [10^minExp, 10^maxExp)
+struct SketchLayout
+{
+    uint32_t binsPerDecade { 100 };
+    int32_t minExp { -10 };
+    int32_t maxExp { 6 };
+
+    std::size_t bins() const { return static_cast<std::size_t>(maxExp - minExp) * binsPerDecade; }
+    bool operator==(const SketchLayout&) const = default;
+};
+
+// Streaming log-binned histogram of signed values: the `SketchLayout` bins of |x| for either sign,
+// plus counts of zeros and of magnitudes below and above their range. Sketches of the same layout merge
+// exactly (their counts add), so it doubles as a mergeable quantile sketch: a quantile read off the bins is the
+// geometric center of the bin holding it, within a relative error of 10^(1 / (2 binsPerDecade)) - 1 (1.2% at 100 bins
+// per decade) whatever the number of values, and its histograms rebin exactly to any divisor of `binsPerDecade`.
+class LogSketch
+{
+private:
+    SketchLayout m_layout;
+    std::vector<uint64_t> m_positive; // bin k counts |x| in [10^(minExp + k / binsPerDecade), 10^(minExp + (k + 1) / binsPerDecade))
+    std::vector<uint64_t> m_negative;
+    uint64_t m_zero { 0 };
+    std::array<uint64_t, 2> m_underflow { 0, 0 }; // positive, negative
+    std::array<uint64_t, 2> m_overflow { 0, 0 };
+    double m_min; // extreme values added, returned for the quantiles outside the binned range
+    double m_max;
+
+    // the value standing for bin k of either sign
+    double center(std::size_t k) const;
+
+    friend class SketchAggregator;
+
+public:
+    explicit LogSketch(const SketchLayout& layout = SketchLayout{});
+
+    void add(double x);
+    void add(const std::vector<double>& values) { for (double x : values) { add(x); } }
+    // throws `std::invalid_argument` if the layouts differ
+    void merge(const LogSketch& other);
+
+    uint64_t count() const;
+    uint64_t positives() const;
+    uint64_t negatives() const;
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+
+    // approximate `q` quantile of all values, or of the positive ones only (as plotted by hist.py); NaN if there are none
+    double quantile(double q, bool positiveOnly = false) const;
+
+    const SketchLayout& layout() const { return m_layout; }
+    const std::vector<uint64_t>& positiveBins() const { return m_positive; }
+    const std::vector<uint64_t>& negativeBins() const { return m_negative; }
+
+    // count, fraction of negative values and the 50/90/99% quantiles of the positive ones
+    void print(std::ostream& os) const;
+};
+
+// `LogSketch`es of the Rayleigh quotients of a headless ensemble, kept in a directory:
+//   parts/<run>_<worker>.sketch : what one worker of one process added
+//   aggregate.sketch            : the sum of every part file, written by `writeAggregate`
+// Every file holds `partitions` sketches, task `id` going to partition `id % partitions`, so the spread of a statistic
+// between merges of disjoint partitions stands in for resampling the raw values (see `sketch.py`).
+// Every worker adds to its own sketches only, so workers neither lock nor contend, and saves them (synced and renamed
+// into place) after each task, before the manifest marks it done. A task interrupted in between is sketched again on
+// restart, i.e. counted twice.
+class SketchAggregator
+{
+private:
+    std::string m_directory;
+    std::string m_run; // prefix of this process's part files
+    SketchLayout m_layout;
+    std::vector<std::vector<LogSketch>> m_sketches; // per worker, per partition
+
+    void save(const std::string& filename, const std::vector<LogSketch>& sketches) const;
+    std::vector<LogSketch> load(const std::string& filename) const;
+
+public:
+    SketchAggregator(const std::string& directory, std::size_t nWorkers, std::size_t partitions = 16, const SketchLayout& layout = SketchLayout{});
+
+    // called by worker `worker_ID` only
+    void add(std::size_t worker_ID, std::size_t taskId, const std::vector<double>& values);
+
+    // sums the part files of every run in the directory, per partition; call once the workers are done
+    std::vector<LogSketch> merged() const;
+    // writes `merged()` to `aggregate.sketch` and returns the total over all partitions
+    LogSketch writeAggregate() const;
+
+    const std::string& directory() const { return m_directory; }
+};
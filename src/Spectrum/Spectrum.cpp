@@ -0,0 +1,131 @@
+#include "Spectrum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <Eigenvalues>
+
+Spectrum::LanczosResult Spectrum::lanczos(const Operator& A, const Eigen::VectorXd& v0, unsigned int nSteps)
+{
+    const Eigen::Index n { v0.size() };
+    const Eigen::Index m { std::min<Eigen::Index>(nSteps, n) };
+
+    Eigen::MatrixXd V(n, m);
+    Eigen::VectorXd alpha(m), beta(m);
+    Eigen::VectorXd w(n);
+
+    V.col(0) = v0.normalized();
+    Eigen::Index steps { m };
+    for (Eigen::Index j = 0; j < m; ++j)
+    {
+        A(V.col(j), w);
+        alpha(j) = V.col(j).dot(w);
+
+        // full reorthogonalization (twice is enough) keeps ghost Ritz values out of the quadrature
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            w -= V.leftCols(j + 1) * (V.leftCols(j + 1).transpose() * w);
+        }
+
+        beta(j) = w.norm();
+        if (j + 1 == m) { break; }
+        if (beta(j) <= 1e-12 * std::abs(alpha(j)))
+        {
+            // invariant subspace found, quadrature is exact
+            beta(j) = 0.0;
+            steps = j + 1;
+            break;
+        }
+        V.col(j + 1) = w / beta(j);
+    }
+
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig;
+    eig.computeFromTridiagonal(alpha.head(steps), beta.head(steps - 1), Eigen::ComputeEigenvectors);
+
+    LanczosResult result;
+    result.ritz.resize(static_cast<std::size_t>(steps));
+    result.weights.resize(static_cast<std::size_t>(steps));
+    result.residuals.resize(static_cast<std::size_t>(steps));
+    for (Eigen::Index k = 0; k < steps; ++k)
+    {
+        std::size_t K { static_cast<std::size_t>(k) };
+        result.ritz[K] = eig.eigenvalues()(k);
+        result.weights[K] = eig.eigenvectors()(0, k) * eig.eigenvectors()(0, k);
+        result.residuals[K] = std::abs(beta(steps - 1) * eig.eigenvectors()(steps - 1, k));
+    }
+
+    return result;
+}
+
+Spectrum::SpectralDensity::SpectralDensity(std::vector<LanczosResult>&& results)
+: probes { std::move(results) }
+{
+    bool first { true };
+    for (const LanczosResult& r : probes)
+    {
+        if (r.ritz.empty()) { continue; }
+        matvecs += r.ritz.size();
+
+        // Ritz values come out sorted
+        if (first || r.ritz.front() < lambdaMin)
+        {
+            lambdaMin = r.ritz.front();
+            lambdaMinBound = r.residuals.front();
+        }
+        if (first || r.ritz.back() > lambdaMax)
+        {
+            lambdaMax = r.ritz.back();
+            lambdaMaxBound = r.residuals.back();
+        }
+        first = false;
+    }
+}
+
+void Spectrum::SpectralDensity::histogram(const std::vector<double>& binEdges, std::vector<double>& density, std::vector<double>& error, double sigma) const
+{
+    const std::size_t nBins { binEdges.size() > 1 ? binEdges.size() - 1 : 0 };
+    density.assign(nBins, 0.0);
+    error.assign(nBins, 0.0);
+    if (nBins == 0 || probes.empty()) { return; }
+
+    // mass each probe puts in each bin
+    std::vector<double> mass(nBins);
+    for (const LanczosResult& r : probes)
+    {
+        std::fill(mass.begin(), mass.end(), 0.0);
+        for (std::size_t k = 0; k < r.ritz.size(); ++k)
+        {
+            double x { r.ritz[k] };
+            if (sigma > 0.0)
+            {
+                auto cdf = [&](double edge){ return 0.5 * std::erfc((x - edge) / (sigma * std::sqrt(2.0))); };
+                for (std::size_t b = 0; b < nBins; ++b)
+                {
+                    mass[b] += r.weights[k] * (cdf(binEdges[b + 1]) - cdf(binEdges[b]));
+                }
+            }
+            else
+            {
+                auto it { std::upper_bound(binEdges.begin(), binEdges.end(), x) };
+                if (it == binEdges.begin() || it == binEdges.end()) { continue; }
+                mass[static_cast<std::size_t>(it - binEdges.begin()) - 1] += r.weights[k];
+            }
+        }
+
+        for (std::size_t b = 0; b < nBins; ++b)
+        {
+            density[b] += mass[b];
+            error[b] += mass[b] * mass[b];
+        }
+    }
+
+    // mean and standard error of the mean over probes, per unit width
+    const double n { static_cast<double>(probes.size()) };
+    for (std::size_t b = 0; b < nBins; ++b)
+    {
+        double mean { density[b] / n };
+        double var { n > 1.0 ? std::max(0.0, (error[b] - n * mean * mean) / (n - 1.0)) : 0.0 };
+        double width { binEdges[b + 1] - binEdges[b] };
+        density[b] = mean / width;
+        error[b] = std::sqrt(var / n) / width;
+    }
+}
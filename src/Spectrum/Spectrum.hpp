@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <Dense>
+
+namespace Spectrum
+{
+    // y = A x for a symmetric operator
+    using Operator = std::function<void(const Eigen::VectorXd& x, Eigen::VectorXd& y)>;
+
+    // Gauss quadrature of one Lanczos run: Ritz values, their weights (squared first components,
+    // summing to 1) and the residual bound |beta_m s_mk| (an eigenvalue of A lies within it)
+    struct LanczosResult
+    {
+        std::vector<double> ritz;
+        std::vector<double> weights;
+        std::vector<double> residuals;
+    };
+
+    // `nSteps` steps of Lanczos with full reorthogonalization started from `v0`
+    LanczosResult lanczos(const Operator& A, const Eigen::VectorXd& v0, unsigned int nSteps);
+
+    // stochastic Lanczos quadrature estimate of the spectral density of A, one `LanczosResult` per random probe
+    struct SpectralDensity
+    {
+        std::vector<LanczosResult> probes;
+        double lambdaMin { 0.0 }, lambdaMax { 0.0 }; // extremal Ritz values over all probes
+        double lambdaMinBound { 0.0 }, lambdaMaxBound { 0.0 }; // residual bounds of the two above
+        std::size_t matvecs { 0 };
+
+        SpectralDensity() = default;
+        explicit SpectralDensity(std::vector<LanczosResult>&& results);
+
+        // density per bin (integrates to the fraction of eigenvalues inside the bins) and its standard
+        // error over probes; `sigma` > 0 spreads each quadrature node with a Gaussian of that width
+        void histogram(const std::vector<double>& binEdges, std::vector<double>& density, std::vector<double>& error, double sigma = 0.0) const;
+    };
+}
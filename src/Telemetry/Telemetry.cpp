@@ -0,0 +1,88 @@
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+namespace
+{
+    void writeArray(std::ostream& os, const std::vector<double>& values)
+    {
+        os << '[';
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            if (i > 0) { os << ','; }
+            os << values[i];
+        }
+        os << ']';
+    }
+}
+
+void Telemetry::merge(const Telemetry& other)
+{
+    for (std::size_t k = 0; k < seconds.size(); ++k)
+    {
+        seconds[k] += other.seconds[k];
+        calls[k] += other.calls[k];
+    }
+    failedFactorizations += other.failedFactorizations;
+    failedSolves += other.failedSolves;
+}
+
+double Telemetry::totalSeconds() const
+{
+    return std::accumulate(seconds.begin(), seconds.end(), 0.0);
+}
+
+void Telemetry::writeJSON(std::ostream& os) const
+{
+    const std::ios_base::fmtflags flags { os.flags() };
+    const std::streamsize precision { os.precision() };
+    os << std::setprecision(6);
+
+    os << "{\"phases\":{";
+    for (std::size_t k = 0; k < seconds.size(); ++k)
+    {
+        if (k > 0) { os << ','; }
+        os << '"' << names[k] << "\":{\"seconds\":" << seconds[k] << ",\"calls\":" << calls[k] << '}';
+    }
+    os << "},\"failedFactorizations\":" << failedFactorizations << ",\"failedSolves\":" << failedSolves;
+    os << ",\"conductanceHistory\":";
+    writeArray(os, conductanceHistory);
+    os << ",\"fitnessHistory\":";
+    writeArray(os, fitnessHistory);
+    os << '}';
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void TelemetrySummary::add(const Telemetry& telemetry, std::size_t steps)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_total.merge(telemetry);
+    m_steps.push_back(steps);
+    ++m_runs;
+}
+
+void TelemetrySummary::print(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (m_runs == 0) { return; }
+
+    std::vector<std::size_t> steps { m_steps };
+    std::sort(steps.begin(), steps.end());
+    const double total { m_total.totalSeconds() };
+
+    os << '\n' << "Telemetry over " << m_runs << " runs" << '\n';
+    os << "steps to convergence: min " << steps.front() << ", median " << steps[steps.size() / 2] << ", max " << steps.back() << '\n';
+    os << std::fixed << std::setprecision(3);
+    for (std::size_t k = 0; k < m_total.seconds.size(); ++k)
+    {
+        os << std::setw(15) << Telemetry::names[k] << " : " << std::setw(12) << m_total.seconds[k] << " s ("
+           << std::setw(5) << std::setprecision(1) << (total > 0.0 ? 100.0 * m_total.seconds[k] / total : 0.0) << "%, "
+           << m_total.calls[k] << " calls)" << std::setprecision(3) << '\n';
+    }
+    os << "failed factorizations: " << m_total.failedFactorizations << ", failed iterative solves: " << m_total.failedSolves << '\n';
+    os << std::defaultfloat;
+}
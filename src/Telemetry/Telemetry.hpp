@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// per-phase timers and convergence history of a run; build with -DGRAPH_TELEMETRY=0 to compile the timers and the
+// history out (the records are still written, with zeros)
+#ifndef GRAPH_TELEMETRY
+#define GRAPH_TELEMETRY 1
+#endif
+
+enum class Phase : std::size_t
+{
+    Assembly,      // writing the conductances into the Laplacians
+    Factorization, // sparse LDL^T (and its symbolic analysis) or the multigrid setup
+    Solve,         // triangular solves, refinement sweeps, multigrid-preconditioned CG
+    EdgeKernel,    // flows, growth law and norms over the edges
+    Probe,         // Hessian probing of the converged state (`sampleHSpec`, `spectralDensity`; the assembly and solves of
+                   // probes that refactor the perturbed Laplacian count above instead)
+    Count
+};
+
+struct Telemetry
+{
+    static constexpr std::array<const char*, static_cast<std::size_t>(Phase::Count)> names { "assembly", "factorization", "solve", "edgeKernel", "probe" };
+
+    std::array<double, static_cast<std::size_t>(Phase::Count)> seconds {};
+    std::array<std::size_t, static_cast<std::size_t>(Phase::Count)> calls {};
+    std::size_t failedFactorizations { 0 }; // `solver.info()` other than `Success`
+    std::size_t failedSolves { 0 }; // iterative solves that missed their tolerance
+    // per accepted step: |dD| / |D| (conductance criterion) and relative change of the dissipation (fitness criterion)
+    std::vector<double> conductanceHistory {}, fitnessHistory {};
+
+    void add(Phase phase, double s)
+    {
+        seconds[static_cast<std::size_t>(phase)] += s;
+        ++calls[static_cast<std::size_t>(phase)];
+    }
+
+    void record([[maybe_unused]] double conductanceChange, [[maybe_unused]] double fitnessChange)
+    {
+#if GRAPH_TELEMETRY
+        conductanceHistory.push_back(conductanceChange);
+        fitnessHistory.push_back(fitnessChange);
+#endif
+    }
+
+    // adds the timers and counters of another run (histories are per run and not merged)
+    void merge(const Telemetry& other);
+    // phases are booked exclusively (see `PhaseTimer`), so this is the timed wall time and the shares add up to 1
+    double totalSeconds() const;
+
+    // one JSON object (one line) with the timers, counters and histories
+    void writeJSON(std::ostream& os) const;
+};
+
+// adds the wall time of its scope to one phase, less the time timers nested in it booked to theirs
+class PhaseTimer
+{
+#if GRAPH_TELEMETRY
+private:
+    Telemetry& m_telemetry;
+    Phase m_phase;
+    double m_booked; // total of the phases when the scope was entered
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    PhaseTimer(Telemetry& telemetry, Phase phase)
+    : m_telemetry { telemetry }
+    , m_phase { phase }
+    , m_booked { telemetry.totalSeconds() }
+    , m_start { std::chrono::steady_clock::now() }
+    {}
+    ~PhaseTimer()
+    {
+        const double nested { m_telemetry.totalSeconds() - m_booked };
+        m_telemetry.add(m_phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count() - nested);
+    }
+#else
+public:
+    PhaseTimer(Telemetry&, Phase) {}
+#endif
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+// totals over the runs of a headless ensemble, fed by the workers as their graphs finish
+class TelemetrySummary
+{
+private:
+    mutable std::mutex m_mutex;
+    Telemetry m_total;
+    std::vector<std::size_t> m_steps; // to convergence, per run
+    std::size_t m_runs { 0 };
+
+public:
+    void add(const Telemetry& telemetry, std::size_t steps);
+    void print(std::ostream& os) const;
+};
@@ -0,0 +1,518 @@
+#include "Topology.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // scales and centers `points` into the width x height scene with 5% padding on every side
+    std::vector<glm::fvec2> fit(const std::vector<glm::dvec2>& points, float width, float height)
+    {
+        glm::dvec2 lo { std::numeric_limits<double>::max() }, hi { std::numeric_limits<double>::lowest() };
+        for (const glm::dvec2& q : points) { lo = glm::min(lo, q); hi = glm::max(hi, q); }
+        const double pad { 0.05 };
+        const glm::dvec2 extent { hi - lo };
+        double scale { std::min(extent.x > 0.0 ? (1.0 - 2.0 * pad) * width / extent.x : std::numeric_limits<double>::max(),
+                                extent.y > 0.0 ? (1.0 - 2.0 * pad) * height / extent.y : std::numeric_limits<double>::max()) };
+        if (scale == std::numeric_limits<double>::max()) { scale = 1.0; }
+        const glm::dvec2 center { 0.5 * static_cast<double>(width), 0.5 * static_cast<double>(height) };
+
+        std::vector<glm::fvec2> positions;
+        positions.reserve(points.size());
+        for (const glm::dvec2& q : points) { positions.emplace_back(center + scale * (q - 0.5 * (lo + hi))); }
+        return positions;
+    }
+
+    Topology assemble(const std::vector<glm::dvec2>& points, std::vector<std::array<uint32_t, 2>>&& edges, uint32_t sink, float width, float height)
+    {
+        Topology topology;
+        topology.positions = fit(points, width, height);
+        topology.edges = std::move(edges);
+        topology.sink = sink;
+        topology.build();
+        return topology;
+    }
+
+    uint32_t nearest(const std::vector<glm::dvec2>& points, glm::dvec2 target)
+    {
+        uint32_t best { 0 };
+        for (uint32_t i = 1; i < points.size(); ++i)
+        {
+            if (glm::distance(points[i], target) < glm::distance(points[best], target)) { best = i; }
+        }
+        return best;
+    }
+
+    std::vector<glm::dvec2> randomPoints(unsigned int n, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::vector<glm::dvec2> points(n);
+        for (glm::dvec2& q : points) { q.x = uniform(rng); q.y = uniform(rng); }
+        return points;
+    }
+
+    // position of (x, y) along the Hilbert curve through a 2^bits x 2^bits grid
+    uint64_t hilbertIndex(uint32_t x, uint32_t y, unsigned int bits)
+    {
+        uint64_t d { 0 };
+        for (uint32_t s = 1u << (bits - 1); s > 0; s >>= 1)
+        {
+            const uint32_t rx { (x & s) > 0 ? 1u : 0u }, ry { (y & s) > 0 ? 1u : 0u };
+            d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+            // rotate the quadrant
+            if (ry == 0)
+            {
+                if (rx == 1) { x = s - 1 - (x & (s - 1)); y = s - 1 - (y & (s - 1)); }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+    // nodes in Hilbert order of their positions
+    template <typename Point>
+    std::vector<uint32_t> hilbertOrder(const std::vector<Point>& points)
+    {
+        const unsigned int bits { 16 };
+        Point lo { points.empty() ? Point{} : points.front() }, hi { lo };
+        for (const Point& q : points) { lo = glm::min(lo, q); hi = glm::max(hi, q); }
+        const double cells { static_cast<double>((1u << bits) - 1) };
+        auto cell = [&](double v, double a, double b) { return static_cast<uint32_t>(b > a ? (v - a) / (b - a) * cells : 0.0); };
+
+        std::vector<uint64_t> key(points.size());
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            key[i] = hilbertIndex(cell(points[i].x, lo.x, hi.x), cell(points[i].y, lo.y, hi.y), bits);
+        }
+        std::vector<uint32_t> order(points.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+        return order;
+    }
+
+    double orient(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    // > 0 if d lies inside the circumcircle of the counterclockwise triangle abc
+    double inCircle(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d)
+    {
+        const glm::dvec2 ad { a - d }, bd { b - d }, cd { c - d };
+        const double a2 { glm::dot(ad, ad) }, b2 { glm::dot(bd, bd) }, c2 { glm::dot(cd, cd) };
+        return ad.x * (bd.y * c2 - b2 * cd.y) - ad.y * (bd.x * c2 - b2 * cd.x) + a2 * (bd.x * cd.y - bd.y * cd.x);
+    }
+}
+
+std::size_t Topology::bandwidth() const
+{
+    std::size_t width { 0 };
+    for (const auto& [i, j] : edges) { width = std::max<std::size_t>(width, j - i); }
+    return width;
+}
+
+void Topology::build()
+{
+    for (auto& e : edges)
+    {
+        if (e[0] == e[1]) { throw std::invalid_argument("Topology: self-loop at node " + std::to_string(e[0])); }
+        if (e[0] > e[1]) { std::swap(e[0], e[1]); }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    const std::size_t N { positions.size() };
+    offsets.assign(N + 1, 0);
+    for (const auto& [i, j] : edges) { ++offsets[i + 1]; ++offsets[j + 1]; }
+    for (std::size_t v = 0; v < N; ++v) { offsets[v + 1] += offsets[v]; }
+
+    std::vector<std::pair<uint32_t, uint32_t>> entries(2 * edges.size()); // (neighbour, edge)
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t k = 0; k < edges.size(); ++k)
+    {
+        entries[fill[edges[k][0]]++] = { edges[k][1], k };
+        entries[fill[edges[k][1]]++] = { edges[k][0], k };
+    }
+    neighbors.resize(entries.size());
+    incident.resize(entries.size());
+    for (std::size_t v = 0; v < N; ++v)
+    {
+        std::sort(entries.begin() + offsets[v], entries.begin() + offsets[v + 1]);
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e)
+        {
+            neighbors[e] = entries[e].first;
+            incident[e] = entries[e].second;
+        }
+    }
+}
+
+void Topology::permute(const std::vector<uint32_t>& order)
+{
+    if (order.size() != positions.size()) { throw std::invalid_argument("Topology::permute: one entry per node needed"); }
+
+    std::vector<uint32_t> rank(order.size());
+    std::vector<glm::fvec2> moved(order.size());
+    for (uint32_t k = 0; k < order.size(); ++k)
+    {
+        rank[order[k]] = k;
+        moved[k] = positions[order[k]];
+    }
+    positions = std::move(moved);
+    for (auto& e : edges) { e = { rank[e[0]], rank[e[1]] }; }
+    sink = rank[sink];
+    build();
+}
+
+void Topology::reorder(NodeOrdering ordering)
+{
+    const uint32_t N { static_cast<uint32_t>(positions.size()) };
+    std::vector<uint32_t> order;
+    order.reserve(N);
+
+    if (ordering == NodeOrdering::Natural)
+    {
+        return;
+    }
+    else if (ordering == NodeOrdering::Hilbert)
+    {
+        order = hilbertOrder(positions);
+    }
+    else
+    {
+        auto degree = [this](uint32_t v) { return offsets[v + 1] - offsets[v]; };
+        std::vector<char> placed(N, 0);
+        std::vector<uint32_t> level(N, std::numeric_limits<uint32_t>::max());
+
+        // breadth-first levels of the component of `start` among unplaced nodes, returns a node of the last level
+        // with the fewest neighbours and sets `depth` to the number of levels
+        std::vector<uint32_t> visited;
+        auto farthest = [&](uint32_t start, uint32_t& depth)
+        {
+            for (uint32_t v : visited) { level[v] = std::numeric_limits<uint32_t>::max(); }
+            visited.assign(1, start);
+            level[start] = 0;
+            for (std::size_t head = 0; head < visited.size(); ++head)
+            {
+                const uint32_t v { visited[head] };
+                for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e)
+                {
+                    const uint32_t w { neighbors[e] };
+                    if (!placed[w] && level[w] == std::numeric_limits<uint32_t>::max()) { level[w] = level[v] + 1; visited.push_back(w); }
+                }
+            }
+            depth = level[visited.back()];
+            uint32_t best { visited.back() };
+            for (uint32_t v : visited)
+            {
+                if (level[v] == depth && degree(v) < degree(best)) { best = v; }
+            }
+            return best;
+        };
+
+        std::vector<uint32_t> byDegree(N);
+        std::iota(byDegree.begin(), byDegree.end(), 0u);
+        std::stable_sort(byDegree.begin(), byDegree.end(), [&](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+        std::vector<uint32_t> next;
+        for (uint32_t seed : byDegree)
+        {
+            if (placed[seed]) { continue; }
+
+            // pseudo-peripheral start: hop to the far end of the level structure while it gets deeper
+            uint32_t start { seed }, depth { 0 };
+            uint32_t far { farthest(start, depth) };
+            for (int hop = 0; hop < 8; ++hop)
+            {
+                uint32_t farDepth { 0 };
+                const uint32_t candidate { farthest(far, farDepth) };
+                if (farDepth <= depth) { break; }
+                start = far;
+                depth = farDepth;
+                far = candidate;
+            }
+
+            // Cuthill-McKee: breadth first, neighbours by ascending degree
+            const std::size_t first { order.size() };
+            order.push_back(start);
+            placed[start] = 1;
+            for (std::size_t head = first; head < order.size(); ++head)
+            {
+                const uint32_t v { order[head] };
+                next.clear();
+                for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e)
+                {
+                    if (!placed[neighbors[e]]) { placed[neighbors[e]] = 1; next.push_back(neighbors[e]); }
+                }
+                std::stable_sort(next.begin(), next.end(), [&](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+                order.insert(order.end(), next.begin(), next.end());
+            }
+        }
+        std::reverse(order.begin(), order.end());
+    }
+    permute(order);
+}
+
+Topology Topologies::square(unsigned int n, float width, float height)
+{
+    std::vector<glm::dvec2> points;
+    std::vector<std::array<uint32_t, 2>> edges;
+    for (uint32_t x = 0; x < n; ++x)
+    {
+        for (uint32_t y = 0; y < n; ++y)
+        {
+            const uint32_t v { x * n + y };
+            points.emplace_back(x, y);
+            if (y + 1 < n) { edges.push_back({ v, v + 1 }); }
+            if (x + 1 < n) { edges.push_back({ v, v + n }); }
+        }
+    }
+    return assemble(points, std::move(edges), (n * n - 1) / 2, width, height);
+}
+
+Topology Topologies::triangular(unsigned int n, float width, float height)
+{
+    std::vector<glm::dvec2> points(static_cast<std::size_t>(n) * n);
+    std::vector<std::array<uint32_t, 2>> edges;
+    auto index = [n](uint32_t x, uint32_t y) { return x * n + y; };
+    for (uint32_t x = 0; x < n; ++x)
+    {
+        for (uint32_t y = 0; y < n; ++y)
+        {
+            // odd rows sit half a spacing to the right, so each node meets two of the next row
+            points[index(x, y)] = glm::dvec2(x + 0.5 * (y % 2), y * std::sqrt(3.0) / 2.0);
+            if (x + 1 < n) { edges.push_back({ index(x, y), index(x + 1, y) }); }
+            if (y + 1 < n)
+            {
+                edges.push_back({ index(x, y), index(x, y + 1) });
+                if (y % 2 == 0 && x > 0) { edges.push_back({ index(x, y), index(x - 1, y + 1) }); }
+                if (y % 2 == 1 && x + 1 < n) { edges.push_back({ index(x, y), index(x + 1, y + 1) }); }
+            }
+        }
+    }
+    return assemble(points, std::move(edges), index(n / 2, n / 2), width, height);
+}
+
+Topology Topologies::hexagonal(unsigned int n, float width, float height)
+{
+    std::vector<glm::dvec2> points(static_cast<std::size_t>(n) * n);
+    std::vector<std::array<uint32_t, 2>> edges;
+    auto index = [n](uint32_t x, uint32_t y) { return x * n + y; };
+    for (uint32_t x = 0; x < n; ++x)
+    {
+        for (uint32_t y = 0; y < n; ++y)
+        {
+            // unit bonds: the chain zig-zags by +-1/4 around its row, nodes at the top of a zig link straight up
+            const bool up { (x + y) % 2 == 0 };
+            points[index(x, y)] = glm::dvec2(x * std::sqrt(3.0) / 2.0, 1.5 * y + (up ? 0.25 : -0.25));
+            if (x + 1 < n) { edges.push_back({ index(x, y), index(x + 1, y) }); }
+            if (up && y + 1 < n) { edges.push_back({ index(x, y), index(x, y + 1) }); }
+        }
+    }
+    return assemble(points, std::move(edges), index(n / 2, n / 2), width, height);
+}
+
+Topology Topologies::cubic(unsigned int n, float width, float height)
+{
+    std::vector<glm::dvec2> points(static_cast<std::size_t>(n) * n * n);
+    std::vector<std::array<uint32_t, 2>> edges;
+    auto index = [n](uint32_t x, uint32_t y, uint32_t z) { return (x * n + y) * n + z; };
+    for (uint32_t x = 0; x < n; ++x)
+    {
+        for (uint32_t y = 0; y < n; ++y)
+        {
+            for (uint32_t z = 0; z < n; ++z)
+            {
+                // oblique projection, depth at half scale and 30 degrees
+                points[index(x, y, z)] = glm::dvec2(x + 0.5 * z * std::cos(M_PI / 6.0), y + 0.5 * z * std::sin(M_PI / 6.0));
+                if (z + 1 < n) { edges.push_back({ index(x, y, z), index(x, y, z + 1) }); }
+                if (y + 1 < n) { edges.push_back({ index(x, y, z), index(x, y + 1, z) }); }
+                if (x + 1 < n) { edges.push_back({ index(x, y, z), index(x + 1, y, z) }); }
+            }
+        }
+    }
+    return assemble(points, std::move(edges), index(n / 2, n / 2, n / 2), width, height);
+}
+
+Topology Topologies::randomGeometric(unsigned int nNodes, double meanDegree, uint32_t seed, float width, float height)
+{
+    if (nNodes == 0) { throw std::invalid_argument("randomGeometric needs at least one node"); }
+    const std::vector<glm::dvec2> points { randomPoints(nNodes, seed) };
+
+    // N pi r^2 neighbours on average (away from the border); pairs are found through a grid of r x r cells
+    const double r { std::sqrt(meanDegree / (M_PI * nNodes)) };
+    const uint32_t cells { static_cast<uint32_t>(std::clamp(std::floor(1.0 / r), 1.0, 4096.0)) };
+    auto cellOf = [cells](double v) { return std::min(static_cast<uint32_t>(v * cells), cells - 1); };
+    std::vector<uint32_t> start(static_cast<std::size_t>(cells) * cells + 1, 0), members(nNodes);
+    for (const glm::dvec2& q : points) { ++start[cellOf(q.x) * cells + cellOf(q.y) + 1]; }
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    {
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (uint32_t i = 0; i < nNodes; ++i) { members[fill[cellOf(points[i].x) * cells + cellOf(points[i].y)]++] = i; }
+    }
+
+    std::vector<std::array<uint32_t, 2>> edges;
+    for (uint32_t i = 0; i < nNodes; ++i)
+    {
+        const int cx { static_cast<int>(cellOf(points[i].x)) }, cy { static_cast<int>(cellOf(points[i].y)) };
+        for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, static_cast<int>(cells) - 1); ++x)
+        {
+            for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, static_cast<int>(cells) - 1); ++y)
+            {
+                const std::size_t c { static_cast<std::size_t>(x) * cells + static_cast<std::size_t>(y) };
+                for (uint32_t m = start[c]; m < start[c + 1]; ++m)
+                {
+                    const uint32_t j { members[m] };
+                    if (j > i && glm::distance(points[i], points[j]) < r) { edges.push_back({ i, j }); }
+                }
+            }
+        }
+    }
+
+    // the flow needs one connected network: keep the largest component (union-find with path halving)
+    std::vector<uint32_t> parent(nNodes);
+    std::iota(parent.begin(), parent.end(), 0u);
+    auto root = [&](uint32_t v) { while (parent[v] != v) { parent[v] = parent[parent[v]]; v = parent[v]; } return v; };
+    for (const auto& [i, j] : edges) { parent[root(i)] = root(j); }
+    std::vector<uint32_t> size(nNodes, 0);
+    for (uint32_t v = 0; v < nNodes; ++v) { ++size[root(v)]; }
+    const uint32_t largest { static_cast<uint32_t>(std::max_element(size.begin(), size.end()) - size.begin()) };
+
+    std::vector<uint32_t> rank(nNodes, std::numeric_limits<uint32_t>::max());
+    std::vector<glm::dvec2> kept;
+    for (uint32_t v = 0; v < nNodes; ++v)
+    {
+        if (root(v) == largest) { rank[v] = static_cast<uint32_t>(kept.size()); kept.push_back(points[v]); }
+    }
+    std::vector<std::array<uint32_t, 2>> keptEdges;
+    for (const auto& [i, j] : edges)
+    {
+        if (rank[i] != std::numeric_limits<uint32_t>::max()) { keptEdges.push_back({ rank[i], rank[j] }); }
+    }
+    return assemble(kept, std::move(keptEdges), nearest(kept, glm::dvec2(0.5, 0.5)), width, height);
+}
+
+Topology Topologies::delaunay(unsigned int nNodes, uint32_t seed, float width, float height)
+{
+    if (nNodes < 3) { throw std::invalid_argument("delaunay needs at least three nodes"); }
+    std::vector<glm::dvec2> points { randomPoints(nNodes, seed) };
+
+    // Bowyer-Watson: each point replaces the triangles whose circumcircle holds it (a connected cavity) by a fan
+    // to the cavity's boundary. Triangles are counterclockwise, `next[k]` lies across the edge opposite vertex k.
+    struct Triangle
+    {
+        uint32_t v[3];
+        int next[3];
+    };
+    const uint32_t super { nNodes };
+    for (int k = 0; k < 3; ++k)
+    {
+        const double angle { M_PI / 2.0 + 2.0 * M_PI * k / 3.0 };
+        points.emplace_back(0.5 + 50.0 * std::cos(angle), 0.5 + 50.0 * std::sin(angle));
+    }
+    std::vector<Triangle> triangles { Triangle{ { super, super + 1, super + 2 }, { -1, -1, -1 } } };
+
+    struct BoundaryEdge
+    {
+        uint32_t a, b;
+        int outside;
+    };
+    std::vector<int> cavity, stack;
+    std::vector<BoundaryEdge> boundary;
+    std::vector<uint32_t> mark(1, 0); // insertion that put a triangle into the cavity
+    int last { 0 };
+
+    // inserted along a Hilbert curve, so consecutive points are close and the walk to each is short
+    for (uint32_t step = 1; uint32_t p : hilbertOrder(std::vector<glm::dvec2>(points.begin(), points.begin() + nNodes)))
+    {
+        const glm::dvec2& P { points[p] };
+
+        // walk from the last new triangle towards P
+        int t { last };
+        for (bool inside = false; !inside;)
+        {
+            inside = true;
+            for (int k = 0; k < 3; ++k)
+            {
+                const Triangle& T { triangles[static_cast<std::size_t>(t)] };
+                if (orient(points[T.v[(k + 1) % 3]], points[T.v[(k + 2) % 3]], P) < 0.0) { t = T.next[k]; inside = false; break; }
+            }
+        }
+
+        // cavity: the triangle holding P and every neighbour (recursively) whose circumcircle holds it
+        mark.resize(triangles.size(), 0);
+        cavity.assign(1, t);
+        stack.assign(1, t);
+        mark[static_cast<std::size_t>(t)] = step;
+        boundary.clear();
+        while (!stack.empty())
+        {
+            const Triangle T { triangles[static_cast<std::size_t>(stack.back())] };
+            stack.pop_back();
+            for (int k = 0; k < 3; ++k)
+            {
+                const int n { T.next[k] };
+                if (n >= 0 && mark[static_cast<std::size_t>(n)] == step) { continue; }
+                const Triangle* N { n >= 0 ? &triangles[static_cast<std::size_t>(n)] : nullptr };
+                if (N && inCircle(points[N->v[0]], points[N->v[1]], points[N->v[2]], P) > 0.0)
+                {
+                    mark[static_cast<std::size_t>(n)] = step;
+                    cavity.push_back(n);
+                    stack.push_back(n);
+                }
+                else
+                {
+                    boundary.push_back(BoundaryEdge{ T.v[(k + 1) % 3], T.v[(k + 2) % 3], n });
+                }
+            }
+        }
+
+        // the fan reuses the cavity's slots (it has two triangles more)
+        while (cavity.size() < boundary.size())
+        {
+            cavity.push_back(static_cast<int>(triangles.size()));
+            triangles.push_back(Triangle{});
+        }
+        for (std::size_t b = 0; b < boundary.size(); ++b)
+        {
+            const BoundaryEdge& e { boundary[b] };
+            triangles[static_cast<std::size_t>(cavity[b])] = Triangle{ { e.a, e.b, p }, { -1, -1, e.outside } };
+            if (e.outside < 0) { continue; }
+            Triangle& O { triangles[static_cast<std::size_t>(e.outside)] };
+            for (int k = 0; k < 3; ++k)
+            {
+                if (O.v[(k + 1) % 3] == e.b && O.v[(k + 2) % 3] == e.a) { O.next[k] = cavity[b]; }
+            }
+        }
+        // (a, b, p) meets the fan triangle starting at b across (b, p), which meets it back across (p, b)
+        for (std::size_t b = 0; b < boundary.size(); ++b)
+        {
+            for (std::size_t c = 0; c < boundary.size(); ++c)
+            {
+                if (boundary[c].a == boundary[b].b)
+                {
+                    triangles[static_cast<std::size_t>(cavity[b])].next[0] = cavity[c];
+                    triangles[static_cast<std::size_t>(cavity[c])].next[1] = cavity[b];
+                }
+            }
+        }
+        last = cavity.front();
+        ++step;
+    }
+
+    std::vector<std::array<uint32_t, 2>> edges;
+    for (const Triangle& T : triangles)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const uint32_t a { T.v[k] }, b { T.v[(k + 1) % 3] };
+            if (a < super && b < super) { edges.push_back({ std::min(a, b), std::max(a, b) }); }
+        }
+    }
+    points.resize(nNodes);
+    return assemble(points, std::move(edges), nearest(points, glm::dvec2(0.5, 0.5)), width, height);
+}
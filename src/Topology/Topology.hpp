@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// how `Topology::reorder` numbers the nodes
+enum class NodeOrdering
+{
+    Natural,             // as generated
+    ReverseCuthillMcKee, // breadth-first from a peripheral node: small bandwidth, neighbours close in memory
+    Hilbert              // along a Hilbert curve through the positions: spatially close nodes close in memory
+};
+
+// Nodes and undirected edges of a transport network, with its adjacency in compressed sparse row form:
+// the neighbours of node v are `neighbors[offsets[v] .. offsets[v + 1])` (ascending), joined by edges `incident[...]`.
+// Edges are stored as (i, j) with i < j and sorted by (i, j), so a pass over the edges sweeps the nodes in order.
+struct Topology
+{
+    std::vector<glm::fvec2> positions; // in the scene (drawing only, 3D networks are projected)
+    std::vector<std::array<uint32_t, 2>> edges;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> neighbors;
+    std::vector<uint32_t> incident;
+    uint32_t sink { 0 }; // node drawing the total current of the sources (the one nearest the center)
+
+    std::size_t nodeCount() const { return positions.size(); }
+    std::size_t edgeCount() const { return edges.size(); }
+    // largest |i - j| over the edges
+    std::size_t bandwidth() const;
+
+    // sorts `edges` and rebuilds the adjacency (call after changing `edges` directly)
+    void build();
+    // renumbers the nodes, node `order[k]` becoming node k
+    void permute(const std::vector<uint32_t>& order);
+    void reorder(NodeOrdering ordering);
+};
+
+// Generators of the networks `Graph` can evolve (see its `Topology` constructor). Every one fits its nodes into the
+// width x height scene like `Graph::regularLattice` (5% padding), keeping the aspect ratio, and numbers them naturally
+// (lattices like `Graph::regularLattice`, x * n + y, random networks in the order their points were drawn); `reorder` renumbers them.
+namespace Topologies
+{
+    // n x n square lattice (numbered like `Graph::regularLattice`)
+    Topology square(unsigned int n, float width, float height);
+    // n x n nodes of a triangular lattice (every row shifted by half a spacing against the last, degree 6)
+    Topology triangular(unsigned int n, float width, float height);
+    // n x n nodes of a honeycomb (rows of zig-zag chains, every other node linked to the next row, degree 3)
+    Topology hexagonal(unsigned int n, float width, float height);
+    // n x n x n simple cubic lattice (degree 6), drawn in an oblique projection
+    Topology cubic(unsigned int n, float width, float height);
+    // `nNodes` uniform random points linked within the distance that gives them `meanDegree` neighbours on average,
+    // reduced to its largest connected component
+    Topology randomGeometric(unsigned int nNodes, double meanDegree, uint32_t seed, float width, float height);
+    // Delaunay triangulation of `nNodes` uniform random points
+    Topology delaunay(unsigned int nNodes, uint32_t seed, float width, float height);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest of a stream of values from one writer thread to one reader thread without locks or waiting:
+// the writer fills `back()` and `publish`es it, the reader picks up the newest published value with `update` and
+// reads it through `front()`. Three slots let either side work at its own pace; values the reader misses are skipped.
+template <typename T>
+class TripleBuffer
+{
+private:
+    static constexpr uint8_t indexMask { 0x3 };
+    static constexpr uint8_t fresh { 0x4 }; // the middle slot holds a value the reader has not taken yet
+
+    std::array<T, 3> m_slots;
+    uint8_t m_back { 0 }; // writer only
+    std::atomic<uint8_t> m_middle { 1 };
+    uint8_t m_front { 2 }; // reader only
+
+public:
+    explicit TripleBuffer(const T& initial) : m_slots { initial, initial, initial } {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // writer side
+    T& back() { return m_slots[m_back]; }
+    void publish() { m_back = static_cast<uint8_t>(m_middle.exchange(static_cast<uint8_t>(m_back | fresh), std::memory_order_acq_rel) & indexMask); }
+
+    // reader side: true if `front()` changed
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & fresh)) { return false; }
+        m_front = static_cast<uint8_t>(m_middle.exchange(m_front, std::memory_order_acq_rel) & indexMask);
+        return true;
+    }
+    const T& front() const { return m_slots[m_front]; }
+};
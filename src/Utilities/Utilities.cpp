@@ -1,5 +1,25 @@
 #include "Utilities.hpp"
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    std::mutex telemetryMutex; // workers append to one telemetry file
+
+    void fail(const std::string& what)
+    {
+        throw std::ios_base::failure(what + ": " + std::strerror(errno));
+    }
+}
+
 void Utilities::exportCSV(const std::string& filename, const std::vector<double>& data)
 {
     std::ofstream outFile(filename + ".txt");
@@ -41,16 +61,199 @@ void Utilities::addLine(const std::string& filename, const Eigen::VectorXd& data
     outFile << '\n';
 }
 
-void Utilities::parallelGraphs(std::size_t thread_ID, uint32_t seed, const float width, const float height, const unsigned int resolution, const double dt, int iter)
+void Utilities::exportSpectralDensity(const std::string& filename, const Spectrum::SpectralDensity& density)
+{
+    std::ofstream outFile(filename + ".txt");
+    checkFileOpen(outFile);
+
+    // header is a comment so the node/weight columns load directly with np.loadtxt
+    outFile << "# lambda_min " << density.lambdaMin << " +- " << density.lambdaMinBound
+            << " lambda_max " << density.lambdaMax << " +- " << density.lambdaMaxBound
+            << " matvecs " << density.matvecs << '\n';
+    outFile << "# probe,node,weight" << '\n';
+
+    for (std::size_t j = 0; j < density.probes.size(); ++j)
+    {
+        const Spectrum::LanczosResult& r { density.probes[j] };
+        for (std::size_t k = 0; k < r.ritz.size(); ++k)
+        {
+            outFile << j << ',' << r.ritz[k] << ',' << r.weights[k] << '\n';
+        }
+    }
+
+    outFile.close();
+}
+
+void Utilities::writeSynced(const std::string& filename, std::string_view bytes)
+{
+    int fd { ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) };
+    if (fd < 0) { fail("Failed to open " + filename); }
+
+    const char* data { bytes.data() };
+    std::size_t size { bytes.size() };
+    while (size > 0)
+    {
+        ssize_t n { ::write(fd, data, size) };
+        if (n < 0)
+        {
+            if (errno == EINTR) { continue; }
+            ::close(fd);
+            fail("Failed to write " + filename);
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    if (::fsync(fd) != 0) { ::close(fd); fail("Failed to sync " + filename); }
+    ::close(fd);
+}
+
+void Utilities::replaceSynced(const std::string& filename, std::string_view bytes)
+{
+    const std::string temporary { filename + ".tmp" };
+    writeSynced(temporary, bytes);
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) { fail("Failed to rename " + temporary); }
+}
+
+ResultRecord Utilities::resultRecord(const Task& task, const Graph& graph, const EnsembleConfig& config, ResultKind kind)
+{
+    const Parameters params { graph.parameters() };
+
+    ResultRecord record;
+    record.id = task.id;
+    record.steps = graph.steps();
+    record.seed = task.seed;
+    record.resolution = graph.resolution();
+    record.kind = static_cast<uint32_t>(kind);
+    record.nSources = params.nSources;
+    record.dt = task.dt;
+    record.eps = config.eps;
+    record.D0 = params.D0;
+    record.tol = params.tol;
+    record.D_min = params.D_min;
+    record.c_t = params.c_t;
+    record.alpha = params.alpha;
+    record.beta = params.beta;
+    record.gamma = params.gamma;
+    record.law = static_cast<uint32_t>(params.law);
+    record.costExponent = params.costExponent;
+    return record;
+}
+
+void Utilities::exportTelemetry(const Task& task, const Graph& graph, const EnsembleConfig& config)
+{
+    const IntegratorStats& stats { graph.integratorStats() };
+    std::ostringstream line;
+    line << "{\"id\":" << task.id << ",\"seed\":" << task.seed << ",\"resolution\":" << graph.resolution()
+         << ",\"dt\":" << task.dt << ",\"steps\":" << graph.steps() << ",\"acceptedSteps\":" << stats.steps
+         << ",\"rejectedSteps\":" << stats.rejected << ",\"time\":" << stats.time << ",\"solves\":" << stats.solves
+         << ",\"factorizations\":" << stats.factorizations << ",\"iterations\":" << stats.iterations << ",\"telemetry\":";
+    graph.telemetry().writeJSON(line);
+    line << '}' << '\n';
+
+    if (config.store)
+    {
+        std::lock_guard<std::mutex> guard(telemetryMutex);
+        std::ofstream outFile(config.store->directory() + "/telemetry.jsonl", std::ios::app);
+        checkFileOpen(outFile);
+        outFile << line.str();
+    }
+    else
+    {
+        std::ofstream outFile(config.outputDir + std::to_string(task.id) + "_telemetry.json");
+        checkFileOpen(outFile);
+        outFile << line.str();
+    }
+}
+
+void Utilities::exportResult(std::size_t worker_ID, const Task& task, Graph& graph, const EnsembleConfig& config)
+{
+    const IntegratorStats& stats { graph.integratorStats() };
+    std::cout << '\n' << "Worker " << worker_ID << " (task " << task.id << ')' << '\n' << "Converged!"
+              << " (" << stats.steps << " steps, " << stats.rejected << " rejected, " << stats.solves << " solves, ";
+    if (stats.factorizations < stats.solves) { std::cout << 100.0 * stats.refactorRate() << "% refactored, "; }
+    if (stats.iterations > 0) { std::cout << stats.iterations << " iterations, "; }
+    std::cout << "t = " << stats.time << ')' << '\n';
+    
+    // one probing thread per graph, the scheduler already keeps every core busy
+    if (config.lanczos)
+    {
+        Spectrum::SpectralDensity density { graph.spectralDensity(config.nProbes, config.nLanczosSteps, 1) };
+        if (config.store)
+        {
+            std::vector<double> pairs;
+            for (const Spectrum::LanczosResult& r : density.probes)
+            {
+                for (std::size_t k = 0; k < r.ritz.size(); ++k)
+                {
+                    pairs.push_back(r.ritz[k]);
+                    pairs.push_back(r.weights[k]);
+                }
+            }
+            config.store->append(resultRecord(task, graph, config, ResultKind::LanczosQuadrature), pairs);
+        }
+        else
+        {
+            Utilities::exportSpectralDensity(config.outputDir + std::to_string(task.id) + "_lanczos", density);
+        }
+    }
+    else
+    {
+        std::vector<double> eigvals { graph.sampleHSpec(config.nSamples, config.eps, 1) };
+        if (config.sketches) { config.sketches->add(worker_ID, task.id, eigvals); }
+        if (config.keepQuotients && config.store)
+        {
+            config.store->append(resultRecord(task, graph, config, ResultKind::RayleighQuotients), eigvals);
+        }
+        else if (config.keepQuotients)
+        {
+            Utilities::exportCSV(config.outputDir + std::to_string(task.id), eigvals);
+        }
+    }
+
+    exportTelemetry(task, graph, config);
+    if (config.telemetry) { config.telemetry->add(graph.telemetry(), graph.steps()); }
+}
+
+void Utilities::parallelGraphs(std::size_t worker_ID, const Task& task, const EnsembleConfig& config, const float width, const float height)
 {
-    Graph graph(seed, width, height, 2 * resolution + 1);
+    // skipped if another worker (or process) holds it, or it finished before an interruption
+    TaskClaim claim;
+    if (config.manifest)
+    {
+        claim = config.manifest->claim(task.id);
+        if (!claim) { return; }
+    }
+
+    Graph graph(task.seed, width, height, 2 * task.resolution + 1);
+    graph.setProbeSolver(config.probeSolver);
+    graph.setIntegrator(config.integrator, config.rtol);
+    graph.setPruning(config.pruning);
+    graph.setPressureSolver(config.pressureSolver);
+    graph.setFactorReuse(config.factorReuse);
+
+    auto finish = [&]()
+    {
+        exportResult(worker_ID, task, graph, config);
+        if (config.manifest) { config.manifest->complete(claim, task, graph.steps()); }
+    };
+
+    // a network converged before (e.g. probed with other settings) is not evolved again
+    if (config.states && config.states->loadConverged(graph, task.dt))
+    {
+        finish();
+        return;
+    }
+    if (config.states && config.states->resume(graph, task.dt))
+    {
+        std::cout << '\n' << "Worker " << worker_ID << " (task " << task.id << ") resumed at step " << graph.steps() << '\n';
+    }
 
     // bool showCC { true };
     // bool showFC { true };
     
     while (true)
     {
-        graph.evolveGraph(dt);
+        graph.evolveGraph(task.dt);
         if (graph.conductanceConverged() && graph.fitConverged())
         // if (graph.conductanceConverged())
         {
@@ -74,16 +277,67 @@ void Utilities::parallelGraphs(std::size_t thread_ID, uint32_t seed, const float
             //     break;
             // }
             
-            std::cout << '\n' << "Thread " << thread_ID << '\n' << "Converged!" << '\n';
-            
-            // ************************************
-            // MAKE SURE TO CREATE DIRECTORY FIRST!
-            // ************************************
-            
-            const std::string path { "/Users/max/TKN_Physarum/parallel_data_1e-4_many_graphs_" + std::to_string(resolution) + "_clamp_1" + '/' };
-            Utilities::exportCSV(path + std::to_string(thread_ID + 8 * static_cast<size_t>(iter)), graph.sampleHSpec(1000, 1e-4));
+            if (config.states) { config.states->saveConverged(graph, task.dt); }
+            finish();
             break;
         }
+        if (config.states && config.checkpointInterval > 0 && graph.steps() % config.checkpointInterval == 0)
+        {
+            config.states->checkpoint(graph, task.dt);
+        }
     }
 }
 
+void Utilities::batchedGraphs(std::size_t worker_ID, std::span<const Task> tasks, const EnsembleConfig& config, const float width, const float height)
+{
+    if (config.integrator != Integrator::Euler || config.pruning.enabled || config.pressureSolver != PressureSolver::Cholesky || config.factorReuse.enabled)
+    {
+        throw std::invalid_argument("batched ensembles only support Euler steps with fresh Cholesky factors and without pruning");
+    }
+
+    // networks converged before are exported from their stored state, the others join the batch
+    const unsigned int resolution { 2 * tasks.front().resolution + 1 };
+    std::vector<Task> pending;
+    std::vector<TaskClaim> claims; // of the pending tasks, while a manifest is used
+    for (const Task& task : tasks)
+    {
+        TaskClaim claim;
+        if (config.manifest)
+        {
+            claim = config.manifest->claim(task.id);
+            if (!claim) { continue; }
+        }
+        if (config.states && config.states->contains(task.seed, resolution, Parameters{}, config.evolution(), task.dt))
+        {
+            Graph graph(task.seed, width, height, resolution);
+            graph.setProbeSolver(config.probeSolver);
+            if (config.states->loadConverged(graph, task.dt))
+            {
+                exportResult(worker_ID, task, graph, config);
+                if (config.manifest) { config.manifest->complete(claim, task, graph.steps()); }
+                continue;
+            }
+        }
+        pending.push_back(task);
+        claims.push_back(std::move(claim));
+    }
+    if (pending.empty()) { return; }
+
+    // the tasks share resolution and dt, their graphs are evolved in lock step and exported as they converge
+    std::vector<uint32_t> seeds;
+    seeds.reserve(pending.size());
+    for (const Task& task : pending) { seeds.push_back(task.seed); }
+
+    GraphBatch batch(seeds, width, height, resolution);
+    while (batch.activeCount() > 0)
+    {
+        for (std::size_t b : batch.evolve(pending.front().dt))
+        {
+            Graph& graph { batch.graph(b) };
+            graph.setProbeSolver(config.probeSolver);
+            if (config.states) { config.states->saveConverged(graph, pending[b].dt); }
+            exportResult(worker_ID, pending[b], graph, config);
+            if (config.manifest) { config.manifest->complete(claims[b], pending[b], graph.steps()); }
+        }
+    }
+}
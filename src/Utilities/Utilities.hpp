@@ -2,16 +2,61 @@
 
 #include <iostream>
 #include <fstream>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "../Graph/Graph.hpp"
+#include "../GraphBatch/GraphBatch.hpp"
+#include "../Scheduler/Scheduler.hpp"
+#include "../ResultStore/ResultStore.hpp"
+#include "../Checkpoint/Checkpoint.hpp"
+#include "../Manifest/Manifest.hpp"
+#include "../Sketch/Sketch.hpp"
+
+// settings shared by every graph of a headless ensemble
+struct EnsembleConfig
+{
+    std::string outputDir; // created by `main` if missing
+    ResultStore* store { nullptr }; // binary result store, falls back to one text file per graph when null
+    StateStore* states { nullptr }; // converged networks are loaded from and saved to it, unfinished runs resume from it
+    std::size_t checkpointInterval { 0 }; // steps between checkpoints of unfinished runs (0: none; single-graph workers only)
+    TelemetrySummary* telemetry { nullptr }; // totals over the ensemble (every run also writes its own record)
+    SweepManifest* manifest { nullptr }; // tasks are claimed from it and marked done once their result is written
+    SketchAggregator* sketches { nullptr }; // log-binned histograms of the Rayleigh quotients, merged over the ensemble
+    bool keepQuotients { true }; // also write the raw Rayleigh quotients (false: only the sketches record them)
+    unsigned int nSamples { 1000 }; // Rayleigh quotients per graph
+    double eps { 1e-4 };
+    ProbeSolver probeSolver { ProbeSolver::Preconditioned };
+    Integrator integrator { Integrator::Euler };
+    double rtol { 1e-3 }; // adaptive integrators only
+    PruneOptions pruning {};
+    PressureSolver pressureSolver { PressureSolver::Cholesky };
+    FactorReuseOptions factorReuse {}; // Cholesky solves only
+    std::size_t batchSize { 1 }; // seeds one worker evolves in lock step (`GraphBatch`, Euler with fresh Cholesky factors and without pruning only)
+
+    // export a stochastic Lanczos quadrature of the Hessian spectrum instead of sampled Rayleigh quotients
+    bool lanczos { false };
+    unsigned int nProbes { 16 };
+    unsigned int nLanczosSteps { 40 };
+
+    // the evolution settings above as every graph gets them (part of the `StateStore` key)
+    EvolutionSettings evolution() const
+    {
+        return EvolutionSettings{ .integrator = integrator, .rtol = rtol, .pruning = pruning, .pressureSolver = pressureSolver, .factorReuse = factorReuse };
+    }
+};
 
 namespace Utilities
 {
     void exportCSV(const std::string& filename, const std::vector<double>& data);
     void addLine(const std::string& filename, const std::vector<double>& data);
     void addLine(const std::string& filename, const Eigen::VectorXd& data);
+    void exportSpectralDensity(const std::string& filename, const Spectrum::SpectralDensity& density);
+    ResultRecord resultRecord(const Task& task, const Graph& graph, const EnsembleConfig& config, ResultKind kind);
+    // one JSON line per run: `telemetry.jsonl` in the result store, or `<id>_telemetry.json` next to the text results
+    void exportTelemetry(const Task& task, const Graph& graph, const EnsembleConfig& config);
 
     template <typename FileStream>
     void checkFileOpen(const FileStream& file)
@@ -21,6 +66,17 @@ namespace Utilities
         }
     };
 
-    void parallelGraphs(std::size_t thread_ID, uint32_t seed, const float width, const float height, const unsigned int resolution, const double dt, int iter);
+    // writes `bytes` to `filename` and syncs it to disk (throws `std::ios_base::failure`)
+    void writeSynced(const std::string& filename, std::string_view bytes);
+    // replaces `filename` through a synced temporary (`filename` + ".tmp", so one writer per file) renamed over it:
+    // readers and a crash in between leave either the old file or the whole new one
+    void replaceSynced(const std::string& filename, std::string_view bytes);
+
+    // probe a converged graph and write its spectrum
+    void exportResult(std::size_t worker_ID, const Task& task, Graph& graph, const EnsembleConfig& config);
+
+    void parallelGraphs(std::size_t worker_ID, const Task& task, const EnsembleConfig& config, const float width, const float height);
+    // the tasks of one `GraphBatch` (same resolution and dt)
+    void batchedGraphs(std::size_t worker_ID, std::span<const Task> tasks, const EnsembleConfig& config, const float width, const float height);
 
 }
@@ -3,6 +3,11 @@
 #include <random>
 #include <thread>
 #include <iomanip>
+#include <memory>
+#include <span>
+#include <filesystem>
+#include <atomic>
+#include <chrono>
 
 // OpenGL helpers (this should be put into one thing!)
 #include "VertexBuffer/VertexBuffer.hpp"
@@ -17,22 +22,42 @@
 // project-specific includes go here
 #include "Graph/Graph.hpp"
 #include "Utilities/Utilities.hpp"
+#include "Scheduler/Scheduler.hpp"
+#include "ResultStore/ResultStore.hpp"
+#include "Recorder/Recorder.hpp"
+#include "Manifest/Manifest.hpp"
+#include "Sketch/Sketch.hpp"
+#include "TripleBuffer/TripleBuffer.hpp"
 
 SDL_Window* window;
 SDL_GLContext gl_context;
 
 const uint8_t num_threads { static_cast<uint8_t>(std::thread::hardware_concurrency()) };
+const std::size_t n_graphs { 112 * 8 }; // ensemble size for headless runs
 
 const bool renderGraphics { true };
+const bool recordConductances { false }; // write the conductance trajectory of interactive runs (see plotD.py)
 
-bool is_running;
-bool paused { true };
-bool step { false };
+// shared by the render loop and the simulation thread
+std::atomic<bool> is_running { false };
+std::atomic<bool> paused { true };
+std::atomic<bool> step { false };
+std::atomic<std::size_t> stepsPerFrame { 0 }; // interactive steps per displayed frame (0: as many as the simulation thread manages)
+std::atomic<std::size_t> framesShown { 0 };
+const std::size_t maxStepsPerFrame { 1024 };
 
 const float width { 768.0f };
 const float height { 768.0f };
 
 const double DT { 0.025 };
+const Integrator integrator { Integrator::Euler }; // adaptive integrators take `DT` as their first step
+const double integratorTol { 1e-3 }; // relative tolerance of the adaptive integrators
+const bool pruneDeadEdges { false }; // drop edges stuck at the conductance floor from the linear system
+const PressureSolver pressureSolver { PressureSolver::Cholesky }; // `Multigrid` for lattices too large to factorize every step (and cheaper late in the evolution)
+const bool reuseFactor { false }; // keep the Cholesky factor while the conductances barely change (refines the pressures against it)
+const std::size_t checkpointInterval { 0 }; // headless steps between checkpoints of unfinished graphs (0: none, e.g. > 0 for long high-resolution runs)
+const std::size_t batchSize { 1 }; // headless seeds per worker evolved in lock step (> 1 needs Euler with fresh Cholesky factors and without pruning)
+const bool keepQuotients { true }; // headless runs also store every Rayleigh quotient, not only their sketches (see `sketch.py`)
 
 // project-specific settings
 unsigned int res { 20 / 2 };
@@ -68,6 +93,19 @@ void evolveTime(SDL_Event& event)
         {
             step = true;
         }
+        else if (event.key.keysym.scancode == SDL_SCANCODE_UP)
+        {
+            // doubling past the maximum lifts the limit
+            const std::size_t n { stepsPerFrame };
+            stepsPerFrame = (n == 0 || n >= maxStepsPerFrame) ? 0 : 2 * n;
+            std::cout << "Steps per frame : " << (stepsPerFrame == 0 ? "unlimited" : std::to_string(stepsPerFrame)) << '\n';
+        }
+        else if (event.key.keysym.scancode == SDL_SCANCODE_DOWN)
+        {
+            const std::size_t n { stepsPerFrame };
+            stepsPerFrame = n == 0 ? maxStepsPerFrame : std::max<std::size_t>(n / 2, 1);
+            std::cout << "Steps per frame : " << stepsPerFrame << '\n';
+        }
         // else if (event.key.keysym.scancode == SDL_SCANCODE_LEFT)
         // {
         //     GLOBAL_TIME < DT ? GLOBAL_TIME = 0.0 : GLOBAL_TIME -= DT; // prevent negative time
@@ -81,12 +119,73 @@ void printKey()
     std::cout << "KEY" << '\n';
     std::cout << "Spacebar" << '\t' << "Play/pause" << '\n';
     std::cout << "Right arrow" << '\t' << "Time forward" << '\n';
+    std::cout << "Up/down arrow" << '\t' << "More/fewer steps per frame" << '\n';
     // std::cout << "Left arrow" << '\t' << "Time reverse" << '\n';
     // std::cout << "Enter/Return" << '\t' << "Reset particles" << '\n';
     std::cout << "###################################" << '\n' << '\n';
 }
 
-int main()
+// conductances and flows of the interactive graph, handed from the simulation thread to the render loop
+struct Snapshot
+{
+    Eigen::VectorXd D;
+    Eigen::VectorXd Q;
+    std::size_t steps { 0 };
+    bool converged { false };
+};
+
+// evolves the interactive graph off the render loop, so the simulation is not tied to vsync: as fast as it can,
+// or at most `stepsPerFrame` steps per displayed frame; every step is published as the newest snapshot
+void simulate(Graph& graph, TripleBuffer<Snapshot>& snapshots, TrajectoryRecorder* recorder)
+{
+    std::size_t frame { framesShown };
+    std::size_t stepsThisFrame { 0 };
+    while (is_running)
+    {
+        if (paused && !step)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (framesShown != frame)
+        {
+            frame = framesShown;
+            stepsThisFrame = 0;
+        }
+        const std::size_t limit { stepsPerFrame };
+        if (!step && limit > 0 && stepsThisFrame >= limit)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        step = false;
+
+        graph.evolveGraph(DT);
+        ++stepsThisFrame;
+        if (recorder) { recorder->record(graph.steps(), graph.getD()); }
+        // func wrapper for "write fitness to file"
+        // std::cout << "##############################################" << '\n';
+        // std::cout << "DE :" << '\t' << std::fixed << std::setprecision(9) << graph.dissipation() << '\n';
+        // std::cout << "TE :" << '\t' << graph.efficiency(D) << '\n';
+
+        const bool converged { graph.conductanceConverged() && graph.fitConverged() };
+        Snapshot& snapshot { snapshots.back() };
+        snapshot.D = graph.getD();
+        snapshot.Q = graph.getQ();
+        snapshot.steps = graph.steps();
+        snapshot.converged = converged;
+        snapshots.publish();
+        if (converged)
+        {
+            // const std::string path { "/Users/max/TKN_Physarum/" };
+            // Utilities::exportCSV(path + "data", graph.sampleHSpec(1000, 1e-1));
+            // graph.printSpec(graph.sampleHSpec(50, 1e-2));
+            return;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
 {
     if (renderGraphics)
     {
@@ -122,6 +221,10 @@ int main()
             // make graph odd x odd so that there is always a central node
             // Graph graph(2499653597, width, height, 2 * res + 1); for N = 25 conductance graph
             Graph graph(rd(), width, height, 2 * res + 1);
+            graph.setIntegrator(integrator, integratorTol);
+            graph.setPruning(PruneOptions{ .enabled = pruneDeadEdges });
+            graph.setPressureSolver(pressureSolver);
+            graph.setFactorReuse(FactorReuseOptions{ .enabled = reuseFactor });
 
             std::vector<Circle> circs;
             circs.reserve(graph.nodeCount());
@@ -160,8 +263,6 @@ int main()
             
             // const Eigen::SparseMatrix<double>& Laplacian { graph.getL() };
             const std::vector<Edge>& edges { graph.edges() };
-            const Eigen::VectorXd& D { graph.getD() };
-            const Eigen::VectorXd& Q { graph.getQ() };
 
             // TODO:
             // 1. add `line` class to OpenGL engine
@@ -243,9 +344,19 @@ int main()
 
             Renderer renderer;
 
+            std::unique_ptr<TrajectoryRecorder> recorder;
+            if (recordConductances)
+            {
+                recorder = std::make_unique<TrajectoryRecorder>("/Users/max/TKN_Physarum/conductances_largeInit", graph.edgeCount());
+            }
+
+            // from here on the graph belongs to the simulation thread, the render loop only sees its snapshots
+            TripleBuffer<Snapshot> snapshots(Snapshot{ graph.getD(), graph.getQ(), graph.steps(), false });
+            is_running = true;
+            std::thread simulation(simulate, std::ref(graph), std::ref(snapshots), recorder.get());
+
             // Main loop
             SDL_Event event;
-            is_running = true;
 
             while(is_running)
             {
@@ -259,34 +370,6 @@ int main()
                     evolveTime(event);
                 }
 
-                // evolve time if unpaused
-                if (not paused)
-                {
-                    graph.evolveGraph(DT);
-                    // Utilities::addLine("/Users/max/TKN_Physarum/conductances_largeInit", D);
-                    // func wrapper for "write fitness to file"
-                    // std::cout << "##############################################" << '\n';
-                    // std::cout << "DE :" << '\t' << std::fixed << std::setprecision(9) << graph.dissipation() << '\n';
-                    // std::cout << "TE :" << '\t' << graph.efficiency(D) << '\n';
-                    if (graph.conductanceConverged() && graph.fitConverged())
-                    {
-                        // continue;
-                        std::cout << "Conductance and fitness converged!" << '\n';
-                        // paused = true;
-                        // const std::string path { "/Users/max/TKN_Physarum/" };
-                        // Utilities::exportCSV(path + "data", graph.sampleHSpec(1000, 1e-1));
-                        // graph.printSpec(graph.sampleHSpec(50, 1e-2));
-                        is_running = false;
-                    }
-                }
-                if (step)
-                {
-                    // std::mt19937 rng(rd());
-                    // std::cout << graph.probeHessian(rng, 1e-1) << '\n';
-                    graph.evolveGraph(DT);
-                    step = false;
-                }
-
                 // updating and rendering stuff happens here
                 
                 // update buffers (circle position, color, alpha)
@@ -294,31 +377,42 @@ int main()
                 // circles.updateColors(values);
                 // circ_VBO.updateBuffer(circles.m_vertices.data());
 
-                // update line buffer
-                for (unsigned int i = 0; i < edgeCount; ++i)
+                // update line buffer, only if the simulation stepped since the last frame
+                if (snapshots.update())
                 {
-                    // comment the two corresponding lines to have flow show up as that color
-                    // red
-                    // lines.m_vertices[12 * i + 2      ] = 1.0f - static_cast<float>(10 * abs(Q(i)));
-                    // lines.m_vertices[12 * (i + 1) - 4] = 1.0f - static_cast<float>(10 * abs(Q(i)));
+                    const Eigen::VectorXd& D { snapshots.front().D };
+                    const Eigen::VectorXd& Q { snapshots.front().Q };
+                    for (unsigned int i = 0; i < edgeCount; ++i)
+                    {
+                        // comment the two corresponding lines to have flow show up as that color
+                        // red
+                        // lines.m_vertices[12 * i + 2      ] = 1.0f - static_cast<float>(10 * abs(Q(i)));
+                        // lines.m_vertices[12 * (i + 1) - 4] = 1.0f - static_cast<float>(10 * abs(Q(i)));
                     
-                    // green
-                    // lines.m_vertices[12 * i + 3      ] = 1.0f - static_cast<float>(10 * abs(Q(i)));
-                    // lines.m_vertices[12 * (i + 1) - 3] = 1.0f - static_cast<float>(10 * abs(Q(i)));
+                        // green
+                        // lines.m_vertices[12 * i + 3      ] = 1.0f - static_cast<float>(10 * abs(Q(i)));
+                        // lines.m_vertices[12 * (i + 1) - 3] = 1.0f - static_cast<float>(10 * abs(Q(i)));
 
-                    // // blue
-                    // lines.m_vertices[12 * i + 4      ] = 1.0f - static_cast<float>(10 * abs(Q(i)));
-                    // lines.m_vertices[12 * (i + 1) - 2] = 1.0f - static_cast<float>(10 * abs(Q(i)));
+                        // // blue
+                        // lines.m_vertices[12 * i + 4      ] = 1.0f - static_cast<float>(10 * abs(Q(i)));
+                        // lines.m_vertices[12 * (i + 1) - 2] = 1.0f - static_cast<float>(10 * abs(Q(i)));
 
-                    // // alpha based on D
-                    // lines.m_vertices[12 * i + 5      ] = static_cast<float>(5 * pow(abs(D(i)), 0.5));
-                    // lines.m_vertices[12 * (i + 1) - 1] = static_cast<float>(5 * pow(abs(D(i)), 0.5));
+                        // // alpha based on D
+                        // lines.m_vertices[12 * i + 5      ] = static_cast<float>(5 * pow(abs(D(i)), 0.5));
+                        // lines.m_vertices[12 * (i + 1) - 1] = static_cast<float>(5 * pow(abs(D(i)), 0.5));
+
+                        lines.updateColor(i, 1.0f, 1.0f, 1.0f - static_cast<float>(10 * abs(Q(i))), static_cast<float>(5 * pow(abs(D(i)), 0.5)));
+                    }
 
-                    lines.updateColor(i, 1.0f, 1.0f, 1.0f - static_cast<float>(10 * abs(Q(i))), static_cast<float>(5 * pow(abs(D(i)), 0.5)));
-                }
 
+                    line_VBO.updateBuffer(lines.m_vertices.data());
 
-                line_VBO.updateBuffer(lines.m_vertices.data());
+                    if (snapshots.front().converged)
+                    {
+                        std::cout << "Conductance and fitness converged! (" << snapshots.front().steps << " steps)" << '\n';
+                        is_running = false;
+                    }
+                }
 
                 renderer.clear();
 
@@ -327,7 +421,9 @@ int main()
                 renderer.drawCircles(circ_VAO, circ_IBO, circ_shader);
 
                 SDL_GL_SwapWindow(window);
+                ++framesShown;
             }
+            simulation.join();
 
             SDL_Quit();
         }
@@ -341,24 +437,81 @@ int main()
     }
     else
     {
-        // TODO: thread pooling
         std::cout << "Thread count: " << static_cast<int>(num_threads) << '\n';
-        for (int i = 0; i < 112; ++i)
+
+        // output directory (first argument, or the default below), created if missing
+        EnsembleConfig config;
+        config.outputDir = argc > 1 ? std::string(argv[1]) + '/' : "/Users/max/TKN_Physarum/parallel_data_1e-4_many_graphs_" + std::to_string(res) + "_clamp_1" + '/';
+        std::filesystem::create_directories(config.outputDir);
+        config.integrator = integrator;
+        config.rtol = integratorTol;
+        config.pruning.enabled = pruneDeadEdges;
+        config.pressureSolver = pressureSolver;
+        config.factorReuse.enabled = reuseFactor;
+        config.batchSize = batchSize;
+
+        // every graph of the ensemble is appended to one binary store (see `resultstore.py`)
+        ResultStore store(config.outputDir + "store");
+        config.store = &store;
+
+        // converged networks are kept, so rerunning the ensemble (e.g. with another `eps` or probe solver) only probes
+        // them again, and unfinished runs resume from their last checkpoint
+        StateStore states(config.outputDir + "states");
+        config.states = &states;
+        config.checkpointInterval = checkpointInterval;
+
+        // where the time went, over every graph of the ensemble
+        TelemetrySummary telemetry;
+        config.telemetry = &telemetry;
+
+        // histograms and quantiles of the Rayleigh quotients of the whole sweep, merged over workers and restarts
+        SketchAggregator sketches(config.outputDir + "sketch", num_threads);
+        config.sketches = &sketches;
+        config.keepQuotients = keepQuotients;
+
+        // seeds of stored (converged or unfinished) networks come first
+        std::vector<uint32_t> stored { states.seeds(2 * res + 1, Parameters{}, config.evolution(), DT) };
+        std::vector<Task> plan;
+        plan.reserve(n_graphs);
+        for (std::size_t i = 0; i < n_graphs; ++i)
         {
-            std::cout << '\n' << "Iteration " << i << '\n' << '\n';
+            plan.push_back(Task{ i, i < stored.size() ? stored[i] : rd(), res, DT });
+        }
 
-            std::vector<std::thread> workers;
-            workers.reserve((num_threads));
-            for (std::size_t thread_ID = 0; thread_ID < num_threads; ++thread_ID)
+        // the plan's seeds only count for the first run in this directory: a restarted sweep (or a second process
+        // joining it) takes the seeds from the manifest already there and skips every task marked done; another
+        // resolution, dt or number of graphs needs another output directory (the manifest throws)
+        SweepManifest manifest(config.outputDir + "sweep", plan, Parameters{});
+        config.manifest = &manifest;
+        const std::vector<Task> tasks { manifest.pending() };
+        std::cout << tasks.size() << " of " << manifest.tasks().size() << " tasks left in " << manifest.directory() << '\n';
+
+        // every worker stays busy until the whole ensemble is done (no per-iteration barrier);
+        // with batching, a scheduled task stands for the batch of `batchSize` pending graphs starting at `id * batchSize`
+        Scheduler scheduler(num_threads, [&config, &tasks](std::size_t worker_ID, const Task& task)
+        {
+            if (config.batchSize > 1)
             {
-                uint32_t base_seed = rd();
-                workers.emplace_back(&Utilities::parallelGraphs, thread_ID, base_seed, width, height, res, DT, i);
+                std::size_t first { task.id * config.batchSize };
+                std::span<const Task> batch(tasks.begin() + static_cast<std::ptrdiff_t>(first), std::min(config.batchSize, tasks.size() - first));
+                Utilities::batchedGraphs(worker_ID, batch, config, width, height);
             }
-
-            for (auto& thread : workers)
+            else
             {
-                thread.join();
+                Utilities::parallelGraphs(worker_ID, task, config, width, height);
             }
+        });
+
+        const std::size_t perTask { std::max<std::size_t>(config.batchSize, 1) };
+        for (std::size_t first = 0; first < tasks.size(); first += perTask)
+        {
+            scheduler.submit(perTask > 1 ? Task{ first / perTask, tasks[first].seed, tasks[first].resolution, tasks[first].dt } : tasks[first]);
         }
+        scheduler.wait();
+
+        scheduler.printSummary(std::cout);
+        telemetry.print(std::cout);
+        sketches.writeAggregate().print(std::cout);
+        scheduler.exportReport("scheduler_report");
     }
 }
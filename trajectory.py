@@ -0,0 +1,34 @@
+import numpy as np
+
+# reader for files written by `TrajectoryRecorder` (src/Recorder/Recorder.hpp)
+
+def load_trajectory(filename):
+    """Read a `TrajectoryRecorder` file, returns (steps, D) with D of shape (frames, edges)."""
+    with open(filename, 'rb') as f:
+        buf = f.read()
+    if buf[:8] != b'TKNTRAJ1':
+        raise ValueError(f'{filename} is not a trajectory file')
+    encoding, = np.frombuffer(buf, '<u4', 1, 12)
+    n_edges, = np.frombuffer(buf, '<u8', 1, 16)
+    quantum, = np.frombuffer(buf, '<f8', 1, 32)
+    n_edges = int(n_edges)
+
+    int_types = {1: '<i1', 2: '<i2', 4: '<i4'}
+    steps, frames = [], []
+    q = np.zeros(n_edges, dtype=np.int64)
+    pos = 40
+    while pos + 16 <= len(buf):
+        kind, width = buf[pos], buf[pos + 1]
+        step, = np.frombuffer(buf, '<u8', 1, pos + 8)
+        pos += 16
+        if pos + width * n_edges > len(buf):
+            break # frame cut short by an interrupted run
+        if kind == 0:
+            frames.append(np.frombuffer(buf, '<f8', n_edges, pos).copy())
+        else:
+            values = np.frombuffer(buf, int_types[width], n_edges, pos).astype(np.int64)
+            q = values if kind == 1 else q + values
+            frames.append(10.0 ** (q * quantum))
+        steps.append(int(step))
+        pos += width * n_edges
+    return np.array(steps), np.array(frames)